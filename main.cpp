@@ -8,9 +8,11 @@
 #include "src/utils/CryptoUtils.h"
 #include "src/utils/InputUtils.h"
 #include "src/utils/UIUtils.h"
+#include "src/utils/IOError.h"
 #include "src/modes/SimpleCipher.cpp"
 #include "src/modes/CBCCipher.cpp"
 #include "src/modes/CTRCipher.cpp"
+#include "src/modes/FileCipher.cpp"
 
 using namespace std;
 
@@ -28,9 +30,7 @@ void processECBEncryption() {
         // Crear nueva instancia para generar clave aleatoria fresca
         SimpleCipher cipher;
         
-        vector<bitset<16>> textBlocks = CryptoUtils::stringToBlocks(plaintext);
-        vector<bitset<16>> cipherBlocks = cipher.encryptMessage(textBlocks);
-        string base64Result = CryptoUtils::blocksToBase64(cipherBlocks);
+        string base64Result = cipher.encryptToBase64(plaintext);
         string masterKeyBase64 = cipher.getMasterKeyBase64();
         
         UIUtils::displayResult("MENSAJE ORIGINAL", "\"" + plaintext + "\"");
@@ -53,9 +53,7 @@ void processECBDecryption() {
         SimpleCipher cipher;
         cipher.setMasterKeyFromBase64(masterKeyBase64);
         
-        vector<bitset<16>> cipherBlocks = CryptoUtils::base64ToBlocks(base64Text);
-        vector<bitset<16>> plainBlocks = cipher.decryptMessage(cipherBlocks);
-        string decryptedText = CryptoUtils::blocksToString(plainBlocks);
+        string decryptedText = cipher.decryptFromBase64(base64Text);
         
         UIUtils::displayResult("CLAVE MAESTRA (BASE64)", masterKeyBase64);
         UIUtils::displayResult("MENSAJE CIFRADO ECB (BASE64)", base64Text);
@@ -80,11 +78,10 @@ void processCBCEncryption() {
         // Crear nueva instancia para generar clave aleatoria fresca
         CBCCipher cipher;
         
-        vector<bitset<16>> textBlocks = CryptoUtils::stringToBlocks(plaintext);
-        auto [iv, cipherBlocks] = cipher.encryptCBC(textBlocks);
-        string base64Result = CryptoUtils::blocksToBase64(cipherBlocks);
+        uint16_t iv;
+        string base64Result = cipher.encryptToBase64(plaintext, iv);
         string masterKeyBase64 = cipher.getMasterKeyBase64();
-        string ivBase64 = CryptoUtils::bitsetToBase64(iv);
+        string ivBase64 = CryptoUtils::bitsetToBase64(bitset<16>(iv));
         
         UIUtils::displayResult("MENSAJE ORIGINAL", "\"" + plaintext + "\"");
         UIUtils::displayResult("CLAVE MAESTRA (BASE64)", masterKeyBase64);
@@ -108,9 +105,7 @@ void processCBCDecryption() {
         CBCCipher cipher;
         cipher.setMasterKeyFromBase64(masterKeyBase64);
         
-        vector<bitset<16>> cipherBlocks = CryptoUtils::base64ToBlocks(base64Text);
-        vector<bitset<16>> plainBlocks = cipher.decryptCBC(iv, cipherBlocks);
-        string decryptedText = CryptoUtils::blocksToString(plainBlocks);
+        string decryptedText = cipher.decryptFromBase64(static_cast<uint16_t>(iv.to_ulong()), base64Text);
         string ivBase64 = CryptoUtils::bitsetToBase64(iv);
         
         UIUtils::displayResult("CLAVE MAESTRA (BASE64)", masterKeyBase64);
@@ -137,11 +132,10 @@ void processCTREncryption() {
         // Crear nueva instancia para generar clave aleatoria fresca
         CTRCipher cipher;
         
-        vector<bitset<16>> textBlocks = CryptoUtils::stringToBlocks(plaintext);
-        auto [iv, cipherBlocks] = cipher.encryptCTR(textBlocks);
-        string base64Result = CryptoUtils::blocksToBase64(cipherBlocks);
+        uint8_t iv;
+        string base64Result = cipher.encryptToBase64(plaintext, iv);
         string masterKeyBase64 = cipher.getMasterKeyBase64();
-        string ivBase64 = CryptoUtils::bitsetToBase648(iv);
+        string ivBase64 = CryptoUtils::bitsetToBase648(bitset<8>(iv));
         
         UIUtils::displayResult("MENSAJE ORIGINAL", "\"" + plaintext + "\"");
         UIUtils::displayResult("CLAVE MAESTRA (BASE64)", masterKeyBase64);
@@ -165,9 +159,7 @@ void processCTRDecryption() {
         CTRCipher cipher;
         cipher.setMasterKeyFromBase64(masterKeyBase64);
 
-        vector<bitset<16>> cipherBlocks = CryptoUtils::base64ToBlocks(base64Text);
-        vector<bitset<16>> plainBlocks = cipher.decryptCTR(iv, cipherBlocks);        
-        string decryptedText = CryptoUtils::blocksToString(plainBlocks);
+        string decryptedText = cipher.decryptFromBase64(static_cast<uint8_t>(iv.to_ulong()), base64Text);
         string ivBase64 = CryptoUtils::bitsetToBase648(iv);
         
         UIUtils::displayResult("CLAVE MAESTRA (BASE64)", masterKeyBase64);
@@ -180,6 +172,45 @@ void processCTRDecryption() {
     }
 }
 
+// Procesar cifrado de archivo
+void processFileEncryption() {
+    try {
+        cin.ignore(); // Limpiar buffer después de leer opción del menú
+        StreamMode mode = FileCipher::parseMode(InputUtils::getTextInput("\nIngrese el modo (ECB, CBC o CTR): "));
+        string inputPath = InputUtils::getTextInput("Ingrese la ruta del archivo a cifrar: ");
+        string outputPath = InputUtils::getTextInput("Ingrese la ruta del archivo cifrado: ");
+
+        // Crear nueva instancia para generar clave aleatoria fresca
+        FileCipher cipher;
+        uint64_t encryptedSize = cipher.encryptFile(inputPath, outputPath, mode);
+
+        UIUtils::displayResult("CLAVE MAESTRA (BASE64)", cipher.getMasterKeyBase64());
+        UIUtils::displayResult("ARCHIVO CIFRADO", outputPath + " (" + to_string(encryptedSize) + " bytes)");
+
+    } catch (const exception& e) {
+        UIUtils::showError("el cifrado del archivo", e.what());
+    }
+}
+
+// Procesar descifrado de archivo (el modo y el IV se leen del encabezado)
+void processFileDecryption() {
+    try {
+        cin.ignore(); // Limpiar buffer después de leer opción del menú
+        string masterKeyBase64 = InputUtils::getMasterKeyInput();
+        string inputPath = InputUtils::getTextInput("Ingrese la ruta del archivo cifrado: ");
+        string outputPath = InputUtils::getTextInput("Ingrese la ruta del archivo descifrado: ");
+
+        FileCipher cipher;
+        cipher.setMasterKeyFromBase64(masterKeyBase64);
+        uint64_t plaintextSize = cipher.decryptFile(inputPath, outputPath);
+
+        UIUtils::displayResult("ARCHIVO DESCIFRADO", outputPath + " (" + to_string(plaintextSize) + " bytes)");
+
+    } catch (const exception& e) {
+        UIUtils::showError("el descifrado del archivo", e.what());
+    }
+}
+
 // ========== CONTROLADORES DE MENÚ ==========
 
 void handleECBMenu() {
@@ -242,7 +273,154 @@ void handleCTRMenu() {
     }
 }
 
-int main() {
+void handleFileMenu() {
+    string opChoice;
+    while (true) {
+        UIUtils::showFileMenu();
+        cin >> opChoice;
+        if (opChoice == "1") {
+            processFileEncryption();
+        } 
+        else if (opChoice == "2") {
+            processFileDecryption();
+        } 
+        else if (opChoice == "3") {
+            break;
+        } 
+        else {
+            UIUtils::showSimpleError("Opcion invalida. Por favor, seleccione 1, 2 o 3.");
+        }
+    }
+}
+
+// ========== LÍNEA DE COMANDOS ==========
+
+// Códigos de salida del modo no interactivo
+enum class ExitCode : int {
+    SUCCESS = 0,
+    INTERNAL_ERROR = 1,
+    USAGE_ERROR = 2,
+    IO_ERROR = 3,
+    INVALID_DATA = 4
+};
+
+struct CommandLineOptions {
+    string command;
+    string mode;
+    string key;
+    string engine;
+    bool batch = false;
+};
+
+CommandLineOptions parseCommandLine(int argc, char* argv[]) {
+    CommandLineOptions options;
+    options.command = argv[1];
+    for (int i = 2; i < argc; i++) {
+        string argument = argv[i];
+        if (argument == "--batch") {
+            options.batch = true;
+            continue;
+        }
+        if (argument != "--mode" && argument != "--key" && argument != "--engine") {
+            throw invalid_argument("Opcion desconocida: " + argument);
+        }
+        if (i + 1 >= argc) {
+            throw invalid_argument("Falta el valor de " + argument);
+        }
+        string value = argv[++i];
+        if (argument == "--mode") {
+            options.mode = value;
+        } else if (argument == "--key") {
+            options.key = value;
+        } else {
+            options.engine = value;
+        }
+    }
+    return options;
+}
+
+CipherEngine parseEngine(const string& name) {
+    if (name == "reference") return CipherEngine::REFERENCE;
+    if (name == "codebook") return CipherEngine::CODEBOOK;
+    if (name == "ttable") return CipherEngine::TTABLE;
+    if (name == "bitslice") return CipherEngine::BITSLICE;
+    if (name == "simd") return CipherEngine::SIMD;
+    throw invalid_argument("Motor invalido: " + name);
+}
+
+// Ejecutar un comando sobre stdin/stdout sin menús; los mensajes van a stderr
+int runCommandLine(int argc, char* argv[]) {
+    CommandLineOptions options;
+    FileCipher cipher;
+    StreamMode mode = StreamMode::ECB;
+    try {
+        options = parseCommandLine(argc, argv);
+        if (options.command == "help" || options.command == "--help") {
+            UIUtils::showUsage(cout);
+            return static_cast<int>(ExitCode::SUCCESS);
+        }
+        if (options.command == "keygen") {
+            cout << cipher.getMasterKeyBase64() << endl;
+            return static_cast<int>(ExitCode::SUCCESS);
+        }
+        if (options.command != "encrypt" && options.command != "decrypt") {
+            throw invalid_argument("Comando desconocido: " + options.command);
+        }
+        if (options.command == "encrypt") {
+            mode = FileCipher::parseMode(options.mode);
+        } else if (options.key.empty()) {
+            throw invalid_argument("decrypt requiere --key");
+        }
+        if (!options.key.empty()) {
+            cipher.setMasterKeyFromBase64(options.key);
+        }
+        if (!options.engine.empty()) {
+            cipher.setEngine(parseEngine(options.engine));
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl << endl;
+        UIUtils::showUsage(cerr);
+        return static_cast<int>(ExitCode::USAGE_ERROR);
+    }
+
+    try {
+        ios::sync_with_stdio(false);
+        cin.tie(nullptr);
+        if (options.command == "encrypt" && options.key.empty()) {
+            cerr << "CLAVE MAESTRA (BASE64): " << cipher.getMasterKeyBase64() << endl;
+        }
+
+        if (options.command == "encrypt") {
+            if (options.batch) {
+                cipher.encryptRecords(cin, cout, mode);
+            } else {
+                cipher.encryptStream(cin, cout, mode);
+            }
+        } else {
+            if (options.batch) {
+                cipher.decryptRecords(cin, cout);
+            } else {
+                cipher.decryptStream(cin, cout);
+            }
+        }
+    } catch (const invalid_argument& e) {
+        cerr << "Error: " << e.what() << endl;
+        return static_cast<int>(ExitCode::INVALID_DATA);
+    } catch (const IOError& e) {
+        cerr << e.what() << endl;
+        return static_cast<int>(ExitCode::IO_ERROR);
+    } catch (const exception& e) {
+        cerr << "Error critico: " << e.what() << endl;
+        return static_cast<int>(ExitCode::INTERNAL_ERROR);
+    }
+    return static_cast<int>(ExitCode::SUCCESS);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        return runCommandLine(argc, argv);
+    }
+
     try {
         string mainChoice;
         
@@ -260,6 +438,9 @@ int main() {
                 handleCTRMenu();
             }
             else if (mainChoice == "4") {
+                handleFileMenu();
+            }
+            else if (mainChoice == "5") {
                 cout << "\nSaliendo del programa..." << endl;
                 break;
             } 
@@ -0,0 +1,116 @@
+#ifndef KEYCACHE_H
+#define KEYCACHE_H
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <stdexcept>
+#include <cstdint>
+#include "SPNetwork.h"
+#include "base/base64.h"
+#include "engines/Codebook.h"
+#include "utils/ShardedClockCache.h"
+
+using namespace std;
+
+// ========== CACHÉ DE CLAVES EXPANDIDAS ==========
+// Guarda, por clave maestra de 16 bits, las llaves de ronda ya expandidas. Las consultas
+// en Base64 se decodifican primero, así que las distintas grafías de una misma clave
+// (con o sin relleno, alfabeto URL) comparten entrada, codebook y contador de usos.
+// Cuando una clave se consulta codebookThreshold veces se le construye además su
+// codebook completo, siempre que quepa en el presupuesto de memoria de un shard.
+class KeyCache {
+public:
+    typedef DefaultSPNetwork Core;
+
+    struct Entry {
+        Core core;
+        shared_ptr<const Codebook> codebook;
+        mutable atomic<uint32_t> uses{0};
+
+        Entry(const Core& entryCore, shared_ptr<const Codebook> entryCodebook)
+            : core(entryCore), codebook(move(entryCodebook)) {}
+    };
+
+    typedef ShardedClockCache<uint16_t, shared_ptr<const Entry>>::Stats Stats;
+
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 64 << 20;
+    static constexpr uint32_t DEFAULT_CODEBOOK_THRESHOLD = 64;
+    // Tablas de cifrado y descifrado de 64K entradas de 16 bits
+    static constexpr size_t CODEBOOK_BYTES = 2 * Codebook::NUM_ENTRIES * sizeof(uint16_t);
+    // Costo aproximado del nodo del índice, el control block y el slot del reloj
+    static constexpr size_t ENTRY_OVERHEAD = 128;
+
+private:
+    ShardedClockCache<uint16_t, shared_ptr<const Entry>> cache;
+    uint32_t codebookThreshold;
+
+    static uint16_t parseMasterKey(const string& base64Key) {
+        string decodedData = base64_decode(base64Key);
+
+        if (decodedData.length() < 2) {
+            throw invalid_argument("Clave Base64 invalida: datos insuficientes");
+        }
+
+        return (static_cast<uint16_t>(static_cast<unsigned char>(decodedData[0])) << 8) |
+               static_cast<uint16_t>(static_cast<unsigned char>(decodedData[1]));
+    }
+
+    static size_t entryCharge(bool withCodebook) {
+        return sizeof(Entry) + ENTRY_OVERHEAD + (withCodebook ? CODEBOOK_BYTES : 0);
+    }
+
+public:
+    // codebookThreshold = 0 desactiva la construcción de codebooks
+    explicit KeyCache(size_t memoryBudget = DEFAULT_MEMORY_BUDGET,
+                      uint32_t threshold = DEFAULT_CODEBOOK_THRESHOLD,
+                      size_t shardCount = ShardedClockCache<uint16_t, shared_ptr<const Entry>>::DEFAULT_SHARDS)
+        : cache(memoryBudget, shardCount), codebookThreshold(threshold) {}
+
+    // Obtener la clave expandida (y su codebook si es una clave caliente)
+    shared_ptr<const Entry> get(uint16_t masterKey) {
+        shared_ptr<const Entry> entry;
+        if (!cache.lookup(masterKey, entry)) {
+            entry = make_shared<const Entry>(Core(masterKey), nullptr);
+            cache.insert(masterKey, entry, entryCharge(false));
+            return entry;
+        }
+
+        // Solo el hilo que alcanza exactamente el umbral construye el codebook
+        uint32_t uses = entry->uses.fetch_add(1, memory_order_relaxed) + 1;
+        if (codebookThreshold != 0 && uses == codebookThreshold && !entry->codebook &&
+            cache.fits(entryCharge(true))) {
+            const Core& core = entry->core;
+            auto codebook = make_shared<const Codebook>([&core](uint16_t block) {
+                return core.encrypt(block);
+            });
+            auto promoted = make_shared<const Entry>(core, codebook);
+            promoted->uses.store(uses, memory_order_relaxed);
+            cache.insert(masterKey, promoted, entryCharge(true));
+            entry = promoted;
+        }
+        return entry;
+    }
+
+    shared_ptr<const Entry> get(const string& base64Key) {
+        return get(parseMasterKey(base64Key));
+    }
+
+    bool erase(uint16_t masterKey) {
+        return cache.erase(masterKey);
+    }
+
+    bool erase(const string& base64Key) {
+        return erase(parseMasterKey(base64Key));
+    }
+
+    void clear() {
+        cache.clear();
+    }
+
+    Stats getStats() const {
+        return cache.getStats();
+    }
+};
+
+#endif
@@ -20,8 +20,8 @@ private:
     int numRounds;
 
     // Función para separar en cuatro nibbles de 4 bits
-    vector<uint8_t> splitToNibbles(uint16_t value) {
-        vector<uint8_t> nibbles(4);
+    array<uint8_t, 4> splitToNibbles(uint16_t value) {
+        array<uint8_t, 4> nibbles;
         nibbles[0] = (value >> 12) & 0xF;
         nibbles[1] = (value >> 8) & 0xF;
         nibbles[2] = (value >> 4) & 0xF;
@@ -30,15 +30,16 @@ private:
     }
     
     // Función para combinar cuatro nibbles en un uint16_t
-    uint16_t combineNibbles(const vector<uint8_t>& nibbles) {
+    uint16_t combineNibbles(const array<uint8_t, 4>& nibbles) {
         return (static_cast<uint16_t>(nibbles[0]) << 12) |
                (static_cast<uint16_t>(nibbles[1]) << 8) |
                (static_cast<uint16_t>(nibbles[2]) << 4) |
                static_cast<uint16_t>(nibbles[3]);
     }
 
+public:
     // Generar clave aleatoria criptográficamente segura
-    uint16_t generateSecureRandomKey() {
+    static uint16_t generateSecureRandomKey() {
         unsigned char randomBytes[2];
         
         int result = RAND_bytes(randomBytes, 2);
@@ -50,7 +51,6 @@ private:
         static_cast<uint16_t>(randomBytes[1]);
     }
 
-public:
     KeySchedule(uint16_t key, int rounds) : masterKey(key), numRounds(rounds) {
         generateRoundKeys();
         generateInverseRoundKeys();
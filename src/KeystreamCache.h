@@ -0,0 +1,70 @@
+#ifndef KEYSTREAMCACHE_H
+#define KEYSTREAMCACHE_H
+
+#include <array>
+#include <memory>
+#include <cstdint>
+#include "utils/ShardedClockCache.h"
+
+using namespace std;
+
+// ========== CACHÉ DE KEYSTREAMS CTR POR (CLAVE, IV) ==========
+// El bloque contador es IV (8 bits) || contador (8 bits), así que un par (clave, IV) tiene
+// solo 256 bloques de keystream (CTRCipher rechaza mensajes más largos): 512 bytes que se
+// generan una sola vez.
+// Con el keystream en caché, cifrar y descifrar en CTR se reduce a un XOR.
+class KeystreamCache {
+public:
+    static constexpr size_t STREAM_BLOCKS = 256;
+    typedef array<uint16_t, STREAM_BLOCKS> Keystream;
+    typedef ShardedClockCache<uint32_t, shared_ptr<const Keystream>>::Stats Stats;
+
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 16 << 20;
+    // Costo aproximado del nodo del índice, el control block y el slot del reloj
+    static constexpr size_t ENTRY_OVERHEAD = 96;
+
+private:
+    ShardedClockCache<uint32_t, shared_ptr<const Keystream>> cache;
+
+    static uint32_t makeKey(uint16_t masterKey, uint8_t iv) {
+        return (static_cast<uint32_t>(masterKey) << 8) | iv;
+    }
+
+public:
+    explicit KeystreamCache(size_t memoryBudget = DEFAULT_MEMORY_BUDGET,
+                            size_t shardCount = ShardedClockCache<uint32_t, shared_ptr<const Keystream>>::DEFAULT_SHARDS)
+        : cache(memoryBudget, shardCount) {}
+
+    // Obtener el keystream de (masterKey, iv); si falta se materializa con
+    // generate(Keystream&), que debe llenar los 256 bloques E(IV || contador)
+    template <typename GenerateFn>
+    shared_ptr<const Keystream> get(uint16_t masterKey, uint8_t iv, const GenerateFn& generate) {
+        uint32_t key = makeKey(masterKey, iv);
+        shared_ptr<const Keystream> keystream;
+        if (cache.lookup(key, keystream)) {
+            return keystream;
+        }
+
+        auto generated = make_shared<Keystream>();
+        generate(*generated);
+        keystream = generated;
+        cache.insert(key, keystream, sizeof(Keystream) + ENTRY_OVERHEAD);
+        return keystream;
+    }
+
+    void clear() {
+        cache.clear();
+    }
+
+    Stats getStats() const {
+        return cache.getStats();
+    }
+
+    // Caché compartido por todo el proceso
+    static KeystreamCache& shared() {
+        static KeystreamCache instance;
+        return instance;
+    }
+};
+
+#endif
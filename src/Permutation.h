@@ -7,48 +7,225 @@
 #include <algorithm>
 #include <numeric>
 #include <iomanip>
+#include <array>
+#include <cstdint>
+#include "utils/CpuFeatures.h"
+
+#ifdef TOYCIPHER_X86_DISPATCH
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
-class Permutation {
-private:
-    vector<int> planckDigits;
-    vector<int> permutationArray;
-    vector<int> inversePermutationArray;
-
-    // Generate the permutation array based on Planck constant
-    void generatePermutationArrays() {
-        // Step 1: Initialize array with values 0-15
-        permutationArray.resize(16);
+// Permutation compiled into word operations
+struct PermutationNetwork {
+    // Delta-swap network (Benes): stage i swaps bits j and j + deltas[i] for every j in masks[i].
+    // Masks are replicated over the four 16-bit lanes of a 64-bit word.
+    int stageCount = 0;
+    int deltas[7] = {};
+    uint64_t masks[7] = {};
+
+    // PEXT/PDEP groups: each group is a set of bits whose order is preserved by the permutation
+    int groupCount = 0;
+    uint16_t sourceMasks[16] = {};
+    uint16_t targetMasks[16] = {};
+};
+
+// Compile-time generation of permutation arrays
+struct PermutationGenerator {
+    typedef array<int, 16> PositionArray;
+
+    // Generate the permutation array from a list of seed digits
+    template <size_t N>
+    static constexpr PositionArray generate(const array<int, N>& digits) {
+        PositionArray positions{};
+
+        // Step 1 and 2: values 0-15 shifted by seed value (1): {1, 2, ..., 15, 0}
         for (int i = 0; i < 16; ++i) {
-            permutationArray[i] = i;
+            positions[i] = (i + 1) % 16;
         }
         
-        // Step 2: Shift array by seed value (1): {1, 2, ..., 15, 0}
-        rotate(permutationArray.begin(), permutationArray.begin() + 1, permutationArray.end());
-        
-        // Step 3: For each digit 'd' in planckDigits, swap positions i and (i + d) mod 16
-        for (size_t i = 0; i < planckDigits.size(); ++i) {
-            int d = planckDigits[i];
-            int swapPos = (i + d) % 16;
-            swap(permutationArray[i], permutationArray[swapPos]);
+        // Step 3: For each digit 'd', swap positions i and (i + d) mod 16
+        for (size_t i = 0; i < N; ++i) {
+            size_t swapPos = (i + digits[i]) % 16;
+            int temp = positions[i];
+            positions[i] = positions[swapPos];
+            positions[swapPos] = temp;
         }
+        return positions;
+    }
 
-        // Generate inverse permutation array
-        inversePermutationArray.resize(16);
+    // Generate the inverse of a permutation array
+    static constexpr PositionArray invert(const PositionArray& positions) {
+        PositionArray inverse{};
         for (int i = 0; i < 16; ++i) {
-            inversePermutationArray[permutationArray[i]] = i;
+            inverse[positions[i]] = i;
         }
+        return inverse;
     }
 
+    // Route one Benes sub-network of the given size; src[d] is the local source of local target d.
+    // Level l uses delta size/2 on stages l (input side) and 6 - l (output side).
+    static constexpr void route(const PositionArray& src, int size, int base, int level, array<uint16_t, 7>& stageMasks) {
+        if (size == 2) {
+            if (src[0] == 1) {
+                stageMasks[3] |= static_cast<uint16_t>(1 << base);
+            }
+            return;
+        }
+
+        int half = size / 2;
+        PositionArray targetOf{};
+        for (int d = 0; d < size; ++d) {
+            targetOf[src[d]] = d;
+        }
+
+        // Looping algorithm: 1 if the source goes through the upper sub-network, -1 if unassigned
+        PositionArray toUpper{};
+        for (int i = 0; i < size; ++i) {
+            toUpper[i] = -1;
+        }
+        for (int start = 0; start < half; ++start) {
+            int s = start;
+            while (toUpper[s] == -1) {
+                int mate = s < half ? s + half : s - half;
+                toUpper[s] = 0;
+                toUpper[mate] = 1;
+                // The target paired with s's target must come from the upper sub-network
+                int target = targetOf[s];
+                int upperSource = src[target < half ? target + half : target - half];
+                if (toUpper[upperSource] != -1) {
+                    break;
+                }
+                toUpper[upperSource] = 1;
+                s = upperSource < half ? upperSource + half : upperSource - half;
+            }
+        }
+
+        PositionArray lowerSrc{}, upperSrc{};
+        for (int k = 0; k < half; ++k) {
+            if (toUpper[k] == 1) {
+                stageMasks[level] |= static_cast<uint16_t>(1 << (base + k));
+            }
+            bool fromUpper = toUpper[src[k]] == 1;
+            if (fromUpper) {
+                stageMasks[6 - level] |= static_cast<uint16_t>(1 << (base + k));
+            }
+            lowerSrc[k] = src[fromUpper ? k + half : k] % half;
+            upperSrc[k] = src[fromUpper ? k : k + half] % half;
+        }
+
+        route(lowerSrc, half, base, level + 1, stageMasks);
+        route(upperSrc, half, base + half, level + 1, stageMasks);
+    }
+
+    // Compile a permutation (target bit i takes source bit positions[i]) into a network
+    static constexpr PermutationNetwork compile(const PositionArray& positions) {
+        PermutationNetwork network{};
+
+        array<uint16_t, 7> stageMasks{};
+        route(positions, 16, 0, 0, stageMasks);
+        const int stageDeltas[7] = {8, 4, 2, 1, 2, 4, 8};
+        for (int i = 0; i < 7; ++i) {
+            if (stageMasks[i] != 0) {
+                uint64_t mask = stageMasks[i];
+                network.deltas[network.stageCount] = stageDeltas[i];
+                network.masks[network.stageCount] = mask | (mask << 16) | (mask << 32) | (mask << 48);
+                network.stageCount++;
+            }
+        }
+
+        // Greedy cover by order-preserving groups, walking the sources in increasing order
+        PositionArray targetOf = invert(positions);
+        int lastTarget[16] = {};
+        for (int source = 0; source < 16; ++source) {
+            int target = targetOf[source];
+            int group = 0;
+            while (group < network.groupCount && lastTarget[group] > target) {
+                group++;
+            }
+            if (group == network.groupCount) {
+                network.groupCount++;
+            }
+            lastTarget[group] = target;
+            network.sourceMasks[group] |= static_cast<uint16_t>(1 << source);
+            network.targetMasks[group] |= static_cast<uint16_t>(1 << target);
+        }
+        return network;
+    }
+};
+
+class Permutation {
 public:
+    typedef PermutationGenerator::PositionArray PositionArray;
 
-    // Constructor
-    Permutation() {
-        // Planck Digits
-        planckDigits = {6, 6, 2, 6, 0, 7, 0, 1, 5};
-        generatePermutationArrays();
+    // Move bit positions[i] of the input to bit i of the output
+    static constexpr uint16_t permuteBits(uint16_t input, const PositionArray& positions) {
+        uint16_t output = 0;
+        for (int i = 0; i < 16; ++i) {
+            output |= static_cast<uint16_t>(((input >> positions[i]) & 1) << i);
+        }
+        return output;
     }
+
+    // Planck Digits
+    static constexpr array<int, 9> PLANCK_DIGITS = {6, 6, 2, 6, 0, 7, 0, 1, 5};
+    static constexpr PositionArray PERMUTATION = PermutationGenerator::generate(PLANCK_DIGITS);
+    static constexpr PositionArray INVERSE_PERMUTATION = PermutationGenerator::invert(PERMUTATION);
+    static constexpr PermutationNetwork NETWORK = PermutationGenerator::compile(PERMUTATION);
+
+private:
+    PositionArray permutationArray;
+    PositionArray inversePermutationArray;
+    PermutationNetwork network;
+
+    // Swap bits j and j + delta for every bit j set in mask
+    template <typename Lane>
+    static Lane deltaSwap(Lane x, int delta, Lane mask) {
+        Lane t = static_cast<Lane>(((x >> delta) ^ x) & mask);
+        return static_cast<Lane>(x ^ t ^ (t << delta));
+    }
+
+    template <typename Lane>
+    Lane applyNetwork(Lane x) const {
+        for (int i = 0; i < network.stageCount; ++i) {
+            x = deltaSwap(x, network.deltas[i], static_cast<Lane>(network.masks[i]));
+        }
+        return x;
+    }
+
+    // Delta swaps are involutions: the inverse runs the stages backwards
+    template <typename Lane>
+    Lane applyInverseNetwork(Lane x) const {
+        for (int i = network.stageCount - 1; i >= 0; --i) {
+            x = deltaSwap(x, network.deltas[i], static_cast<Lane>(network.masks[i]));
+        }
+        return x;
+    }
+
+#ifdef TOYCIPHER_X86_DISPATCH
+    __attribute__((target("bmi2")))
+    static uint16_t applyGroupsBMI2(uint16_t x, const uint16_t* fromMasks, const uint16_t* toMasks, int groupCount) {
+        uint32_t result = 0;
+        for (int i = 0; i < groupCount; ++i) {
+            result |= _pdep_u32(_pext_u32(x, fromMasks[i]), toMasks[i]);
+        }
+        return static_cast<uint16_t>(result);
+    }
+#endif
+
+public:
+
+    // Constructor: the arrays and the network are computed at compile time
+    constexpr Permutation()
+        : permutationArray(PERMUTATION), inversePermutationArray(INVERSE_PERMUTATION), network(NETWORK) {}
+
+    // Constructor for a permutation built from different seed digits
+    template <size_t N>
+    constexpr explicit Permutation(const array<int, N>& digits)
+        : permutationArray(PermutationGenerator::generate(digits)),
+          inversePermutationArray(PermutationGenerator::invert(permutationArray)),
+          network(PermutationGenerator::compile(permutationArray)) {}
     
     // Get the permuted position for a given original position
     int getPermutedPosition(int originalPosition) const {
@@ -66,22 +243,53 @@ public:
         return inversePermutationArray[permutedPosition];
     }
     
+    // Apply permutation to a 16-bit block (PEXT/PDEP when BMI2 is available). The word-width
+    // versions carry the width in their name so integer arguments keep resolving to bitset<16>
+    uint16_t applyPermutation16(uint16_t input) const {
+#ifdef TOYCIPHER_X86_DISPATCH
+        if (CpuFeatures::hasBMI2()) {
+            return applyGroupsBMI2(input, network.sourceMasks, network.targetMasks, network.groupCount);
+        }
+#endif
+        return applyNetwork(input);
+    }
+
+    // Apply inverse permutation to a 16-bit block
+    uint16_t applyInversePermutation16(uint16_t input) const {
+#ifdef TOYCIPHER_X86_DISPATCH
+        if (CpuFeatures::hasBMI2()) {
+            return applyGroupsBMI2(input, network.targetMasks, network.sourceMasks, network.groupCount);
+        }
+#endif
+        return applyInverseNetwork(input);
+    }
+
+    // Apply permutation to two packed 16-bit lanes
+    uint32_t applyPermutation32(uint32_t input) const {
+        return applyNetwork(input);
+    }
+
+    uint32_t applyInversePermutation32(uint32_t input) const {
+        return applyInverseNetwork(input);
+    }
+
+    // Apply permutation to four packed 16-bit lanes
+    uint64_t applyPermutation64(uint64_t input) const {
+        return applyNetwork(input);
+    }
+
+    uint64_t applyInversePermutation64(uint64_t input) const {
+        return applyInverseNetwork(input);
+    }
+
     // Apply permutation to a 16-bit bitset
     bitset<16> applyPermutation(const bitset<16>& input) const {
-        bitset<16> permutedKey;
-        for (size_t i = 0; i < 16; i++) {
-            permutedKey[i] = input[permutationArray[i]];
-        }
-        return permutedKey;
+        return bitset<16>(applyPermutation16(static_cast<uint16_t>(input.to_ulong())));
     }
     
     // Apply inverse permutation to a 16-bit bitset
     bitset<16> applyInversePermutation(const bitset<16>& input) const {
-        bitset<16> originalKey;
-        for (size_t i = 0; i < 16; i++) {
-            originalKey[i] = input[inversePermutationArray[i]];
-        }
-        return originalKey;
+        return bitset<16>(applyInversePermutation16(static_cast<uint16_t>(input.to_ulong())));
     }
     
     // Print the permutation array
@@ -7,84 +7,97 @@
 #include <iomanip>
 #include <sstream>
 #include <bitset>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
 
 using namespace std;
 
 class SBox {
-private:
-    int fieldSize;
-    
+public:
+    // Largest field whose tables are generated at compile time (2^8 entries)
+    static const int MAX_TABLE_FIELD_SIZE = 8;
+
+    // Irreducible polynomial used for each field size
+    static constexpr uint64_t irreduciblePolynomial(int n) {
+        if (n == 4) return 0x1F;
+        if (n == 8) return 0x11B;
+        return (1ULL << n) | 0x3;
+    }
+
     // GF(2^n) multiplication
-    unsigned int multiplyGF2N(unsigned int a, unsigned int b) {
-        unsigned int mask = (1 << fieldSize) - 1;
-        unsigned int irreducible = 0;
-        
-        // Select irreducible polynomial based on field size
-        if (fieldSize == 4) irreducible = 0x1F;
-        else if (fieldSize == 8) irreducible = 0x11B;
-        else irreducible = (1 << fieldSize) | 0x3;
+    static constexpr unsigned int multiplyGF2N(unsigned int a, unsigned int b, int n) {
+        uint64_t mask = (1ULL << n) - 1;
+        uint64_t irreducible = irreduciblePolynomial(n);
+        uint64_t result = 0;
         
-        unsigned int result = 0;
-        
-        // Correct implementation of GF(2^n) multiplication
-        for (int i = 0; i < fieldSize; i++) {
-            if (b & (1 << i)) {
-                result ^= (a << i);
+        for (int i = 0; i < n; i++) {
+            if (b & (1ULL << i)) {
+                result ^= (static_cast<uint64_t>(a) << i);
             }
             
             // Modular reduction after each iteration
-            for (int j = 2 * fieldSize - 2; j >= fieldSize; j--) {
-                if (result & (1 << j)) {
-                    result ^= (irreducible << (j - fieldSize));
+            for (int j = 2 * n - 2; j >= n; j--) {
+                if (result & (1ULL << j)) {
+                    result ^= (irreducible << (j - n));
                 }
             }
         }
         
-        result &= mask;
+        return static_cast<unsigned int>(result & mask);
+    }
+
+    // Multiplicative inverse in GF(2^n): a^(2^n - 2) by square-and-multiply
+    static constexpr unsigned int inverseGF2N(unsigned int a, int n) {
+        unsigned int result = 1;
+        unsigned int power = multiplyGF2N(a, a, n);   // a^2
+        // 2^n - 2 = 2 + 4 + ... + 2^(n-1)
+        for (int i = 1; i < n; i++) {
+            result = multiplyGF2N(result, power, n);
+            power = multiplyGF2N(power, power, n);
+        }
         return result;
     }
 
-    // Extended GCD algorithm
-    int extendedGCD(int a, int n, int &x1, int &x2) {
-        int u = a, v = n;
-        x1 = 1, x2 = 0;
+    // S-box operation: (input XOR 5) * 7 XOR 10
+    static constexpr unsigned int computeSBox(unsigned int element, int n) {
+        return multiplyGF2N(5 ^ element, 7, n) ^ 10;
+    }
 
-        if (a % n == 0) {
-            x1 = 0;
-            x2 = 1;
-            return n;
-        }
-        
-        if (n % a == 0) {
-            x1 = 1;
-            x2 = 0;
-            return a;
-        }
+    // Inverse S-box operation: ((input XOR 10) * 7^-1) XOR 5
+    static constexpr unsigned int computeInverseSBox(unsigned int element, int n) {
+        return multiplyGF2N(10 ^ element, inverseGF2N(7, n), n) ^ 5;
+    }
 
-        while (u != 0 && u != 1) {
-            int q = v / u;
-            int r = v % u;
-            int x = x2 - q * x1;
-            v = u;
-            u = r;
-            x2 = x1;
-            x1 = x;
-
-            if (u == 0) {
-                return v;
+    // Forward and inverse tables for GF(2^N), generated at compile time
+    template <int N>
+    struct Tables {
+        static_assert(N >= 1 && N <= MAX_TABLE_FIELD_SIZE, "Field too large to tabulate");
+        static const size_t SIZE = size_t(1) << N;
+
+        static constexpr array<uint8_t, SIZE> build(bool inverse) {
+            array<uint8_t, SIZE> table{};
+            for (size_t i = 0; i < SIZE; i++) {
+                unsigned int element = static_cast<unsigned int>(i);
+                table[i] = static_cast<uint8_t>(inverse ? computeInverseSBox(element, N) : computeSBox(element, N));
             }
+            return table;
         }
-        return u;
-    }
 
-    // Find multiplicative inverse in finite field
-    unsigned int findInverse(int a, int n) {
-        int x1, x2;
-        int gcdResult = extendedGCD(a, n, x1, x2);
-        if (gcdResult == 1) {
-            return (x1 % n + n) % n;
-        }
-        return 0;
+        static constexpr array<uint8_t, SIZE> forward = build(false);
+        static constexpr array<uint8_t, SIZE> inverse = build(true);
+    };
+
+private:
+    int fieldSize;
+    const uint8_t* forwardTable;    // nullptr when the field is too large to tabulate
+    const uint8_t* inverseTable;
+    unsigned int inverseMultiplier; // 7^-1, only needed without tables
+
+    template <int N>
+    void selectTables() {
+        forwardTable = Tables<N>::forward.data();
+        inverseTable = Tables<N>::inverse.data();
     }
 
     // Convert result to hexadecimal representation
@@ -96,29 +109,38 @@ private:
 
 public:
     // Constructor
-    SBox(int n) : fieldSize(n) {
+    SBox(int n) : fieldSize(n), forwardTable(nullptr), inverseTable(nullptr), inverseMultiplier(0) {
         if (n <= 0 || n > 32) {
             throw invalid_argument("Field size must be between 1 and 32");
         }
+
+        switch (n) {
+            case 1: selectTables<1>(); break;
+            case 2: selectTables<2>(); break;
+            case 3: selectTables<3>(); break;
+            case 4: selectTables<4>(); break;
+            case 5: selectTables<5>(); break;
+            case 6: selectTables<6>(); break;
+            case 7: selectTables<7>(); break;
+            case 8: selectTables<8>(); break;
+            default: inverseMultiplier = inverseGF2N(7, n); break;
+        }
     }
 
-    // Apply S-box transformation to a single element
-    unsigned int applySBox(unsigned int element) {
-        // S-box operation: (input XOR 5) * 7 XOR 10
-        unsigned int firstXor = 5 ^ element;
-        unsigned int multiplyResult = multiplyGF2N(firstXor, 7);
-        unsigned int result = multiplyResult ^ 10;
-        return result;
+    // Apply S-box transformation to a single element (reduced to the field)
+    unsigned int applySBox(unsigned int element) const {
+        if (forwardTable) {
+            return forwardTable[element & ((1u << fieldSize) - 1)];
+        }
+        return multiplyGF2N(5 ^ element, 7, fieldSize) ^ 10;
     }
 
-    // Apply inverse S-box transformation to a single element
-    unsigned int applyInverseSBox(unsigned int element) {
-        // Inverse S-box operation: ((input XOR 10) * 7^-1) XOR 5
-        unsigned int firstXor = 10 ^ element; 
-        unsigned int inverse = findInverse(7, 31);
-        unsigned int multiplyResult = multiplyGF2N(firstXor, inverse);
-        unsigned int result = multiplyResult ^ 5; 
-        return result;
+    // Apply inverse S-box transformation to a single element (reduced to the field)
+    unsigned int applyInverseSBox(unsigned int element) const {
+        if (inverseTable) {
+            return inverseTable[element & ((1u << fieldSize) - 1)];
+        }
+        return multiplyGF2N(10 ^ element, inverseMultiplier, fieldSize) ^ 5;
     }
 
     // Apply S-box to a vector of elements
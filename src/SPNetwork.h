@@ -0,0 +1,130 @@
+#ifndef SPNETWORK_H
+#define SPNETWORK_H
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include "SBox.h"
+#include "Permutation.h"
+
+using namespace std;
+
+// ========== CAPAS DE LA RED SP ==========
+
+// Capa de sustitución: S-box de GF(2^4) aplicada a los cuatro nibbles del estado
+struct SBoxLayer {
+    static uint16_t substitute(uint16_t state) {
+        const auto& table = SBox::Tables<4>::forward;
+        return static_cast<uint16_t>(table[state & 0xF] |
+                                     (table[(state >> 4) & 0xF] << 4) |
+                                     (table[(state >> 8) & 0xF] << 8) |
+                                     (table[state >> 12] << 12));
+    }
+
+    static uint16_t inverseSubstitute(uint16_t state) {
+        const auto& table = SBox::Tables<4>::inverse;
+        return static_cast<uint16_t>(table[state & 0xF] |
+                                     (table[(state >> 4) & 0xF] << 4) |
+                                     (table[(state >> 8) & 0xF] << 8) |
+                                     (table[state >> 12] << 12));
+    }
+};
+
+// Capa de permutación: red delta-swap de la permutación de Planck, con máscaras constantes
+struct PermutationLayer {
+    static uint16_t permute(uint16_t state) {
+        constexpr const PermutationNetwork& network = Permutation::NETWORK;
+        for (int i = 0; i < network.stageCount; i++) {
+            state = deltaSwap(state, network.deltas[i], static_cast<uint16_t>(network.masks[i]));
+        }
+        return state;
+    }
+
+    static uint16_t inversePermute(uint16_t state) {
+        constexpr const PermutationNetwork& network = Permutation::NETWORK;
+        for (int i = network.stageCount - 1; i >= 0; i--) {
+            state = deltaSwap(state, network.deltas[i], static_cast<uint16_t>(network.masks[i]));
+        }
+        return state;
+    }
+
+private:
+    static uint16_t deltaSwap(uint16_t x, int delta, uint16_t mask) {
+        uint16_t t = static_cast<uint16_t>(((x >> delta) ^ x) & mask);
+        return static_cast<uint16_t>(x ^ t ^ (t << delta));
+    }
+};
+
+// ========== NÚCLEO DE LA RED SP PARAMETRIZADO EN TIEMPO DE COMPILACIÓN ==========
+// El número de rondas, la S-box y la permutación son parámetros de plantilla, las llaves
+// de ronda viven en un std::array dentro del objeto y las rondas se desenrollan con
+// expresiones fold, sin comprobaciones de rango ni llamadas a través de punteros.
+template <int Rounds, typename SBoxT = SBoxLayer, typename PermT = PermutationLayer>
+class SPNetwork {
+    // La rotación de la llave de ronda (round - 1) posiciones solo está definida hasta 16 rondas
+    static_assert(Rounds >= 1 && Rounds <= 16, "Numero de rondas fuera de rango (1-16)");
+
+public:
+    static constexpr int NUM_ROUNDS = Rounds;
+    typedef array<uint16_t, Rounds> RoundKeyArray;
+
+private:
+    uint16_t masterKey;
+    RoundKeyArray roundKeys;
+
+    template <int... Round>
+    uint16_t encryptRounds(uint16_t state, integer_sequence<int, Round...>) const {
+        ((state = PermT::permute(SBoxT::substitute(static_cast<uint16_t>(state ^ roundKeys[Round])))), ...);
+        return state;
+    }
+
+    template <int... Round>
+    uint16_t decryptRounds(uint16_t state, integer_sequence<int, Round...>) const {
+        ((state = static_cast<uint16_t>(SBoxT::inverseSubstitute(PermT::inversePermute(state)) ^
+                                        roundKeys[Rounds - 1 - Round])), ...);
+        return state;
+    }
+
+public:
+    // Mismo algoritmo que KeySchedule: sumar 1 a cada nibble y rotar (round - 1) posiciones
+    static constexpr RoundKeyArray expandKey(uint16_t masterKey) {
+        RoundKeyArray keys{};
+        uint16_t currentKey = masterKey;
+        for (int round = 1; round <= Rounds; round++) {
+            uint16_t tempKey = 0;
+            for (int shift = 0; shift < 16; shift += 4) {
+                tempKey |= static_cast<uint16_t>((((currentKey >> shift) + 1) & 0xF) << shift);
+            }
+            uint16_t roundKey = static_cast<uint16_t>((tempKey << (round - 1)) | (tempKey >> (16 - (round - 1))));
+            keys[round - 1] = roundKey;
+            currentKey = roundKey;
+        }
+        return keys;
+    }
+
+    constexpr explicit SPNetwork(uint16_t key = 0) : masterKey(key), roundKeys(expandKey(key)) {}
+
+    uint16_t getMasterKey() const {
+        return masterKey;
+    }
+
+    const RoundKeyArray& getRoundKeys() const {
+        return roundKeys;
+    }
+
+    // Cifrar un bloque de 16 bits con todas las rondas desenrolladas
+    uint16_t encrypt(uint16_t block) const {
+        return encryptRounds(block, make_integer_sequence<int, Rounds>{});
+    }
+
+    // Descifrar un bloque de 16 bits con todas las rondas desenrolladas
+    uint16_t decrypt(uint16_t block) const {
+        return decryptRounds(block, make_integer_sequence<int, Rounds>{});
+    }
+};
+
+// Núcleo del cifrador: 5 rondas con la S-box y la permutación por defecto. SimpleCipher y
+// KeyCache lo toman de aquí para que sus contextos de clave sean siempre del mismo tipo.
+typedef SPNetwork<5> DefaultSPNetwork;
+
+#endif
@@ -29,13 +29,30 @@
 
    René Nyffenegger rene.nyffenegger@adp-gmbh.ch
 
+   ALTERED SOURCE VERSION: this copy has been modified from the original.
+   Changes: table-driven scalar decoding, encoding into a pre-sized buffer,
+   and SSSE3/AVX2 encode/decode paths selected at runtime (CpuFeatures),
+   with the original scalar code handling padding, URL-safe input, line
+   breaks and invalid characters. Whole-group helpers (encode_groups,
+   decode_groups) shared with the streaming codec in base64Stream.h, and an
+   include guard so both can be included in the same translation unit.
+
 */
 
+#ifndef BASE64_CPP
+#define BASE64_CPP
+
 #include "base64.h"
 
 #include <algorithm>
 #include <stdexcept>
 
+#include "../utils/CpuFeatures.h"
+
+#ifdef TOYCIPHER_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
  //
  // Depending on the url parameter in base64_chars, one of
  // two sets of base64 characters needs to be chosen.
@@ -52,17 +69,32 @@ static const char* base64_chars[2] = {
              "0123456789"
              "-_"};
 
+static const unsigned char invalid_char = 0xff;
+
+static const unsigned char* decode_table() {
+ //
+ // Position of every character within base64_encode(), or invalid_char.
+ // Both url ('-', '_') and non-url ('+', '/') characters are accepted.
+ //
+    static const struct Table {
+        unsigned char pos[256];
+        Table() {
+            std::fill(pos, pos + 256, invalid_char);
+            for (unsigned char i = 0; i < 64; i++) {
+                pos[static_cast<unsigned char>(base64_chars[0][i])] = i;
+                pos[static_cast<unsigned char>(base64_chars[1][i])] = i;
+            }
+        }
+    } table;
+    return table.pos;
+}
+
 static unsigned int pos_of_char(const unsigned char chr) {
  //
  // Return the position of chr within base64_encode()
  //
-
-    if      (chr >= 'A' && chr <= 'Z') return chr - 'A';
-    else if (chr >= 'a' && chr <= 'z') return chr - 'a' + ('Z' - 'A')               + 1;
-    else if (chr >= '0' && chr <= '9') return chr - '0' + ('Z' - 'A') + ('z' - 'a') + 2;
-    else if (chr == '+' || chr == '-') return 62; // Be liberal with input and accept both url ('-') and non-url ('+') base 64 characters (
-    else if (chr == '/' || chr == '_') return 63; // Ditto for '/' and '_'
-    else
+    unsigned char pos = decode_table()[chr];
+    if (pos != invalid_char) return pos;
  //
  // 2020-10-23: Throw std::exception rather than const char*
  //(Pablo Martin-Gomez, https://github.com/Bouska)
@@ -70,6 +102,221 @@ static unsigned int pos_of_char(const unsigned char chr) {
     throw std::runtime_error("Input is not valid base64-encoded data.");
 }
 
+#ifdef TOYCIPHER_X86_DISPATCH
+ //
+ // Vectorized paths (W. Muła, D. Lemire: "Faster Base64 Encoding and
+ // Decoding Using AVX2 Instructions"). They only process whole groups
+ // of input and return how much they consumed; the scalar code finishes
+ // the tail, padding and anything the vector code refuses.
+ //
+
+ //
+ // Encode: 12 input bytes per 128-bit lane become 16 six-bit indices,
+ // which are translated to ASCII by adding a per-range offset.
+ //
+__attribute__((target("ssse3")))
+static __m128i encode_indices_ssse3(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+__attribute__((target("ssse3")))
+static __m128i encode_ascii_ssse3(__m128i indices, bool url) {
+    __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+    const __m128i shift_lut = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52,
+        static_cast<char>((url ? '-' : '+') - 62), static_cast<char>((url ? '_' : '/') - 63),
+        'A', 0, 0);
+    result = _mm_shuffle_epi8(shift_lut, result);
+    return _mm_add_epi8(result, indices);
+}
+
+__attribute__((target("ssse3")))
+static size_t encode_ssse3(const unsigned char* in, size_t in_len, char* out, bool url) {
+    size_t pos = 0;
+    for (; pos + 16 <= in_len; pos += 12) {
+        __m128i indices = encode_indices_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + pos)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + pos / 3 * 4), encode_ascii_ssse3(indices, url));
+    }
+    return pos;
+}
+
+__attribute__((target("avx2")))
+static size_t encode_avx2(const unsigned char* in, size_t in_len, char* out, bool url) {
+    const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i shift_lut = _mm256_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52,
+        static_cast<char>((url ? '-' : '+') - 62), static_cast<char>((url ? '_' : '/') - 63),
+        'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52,
+        static_cast<char>((url ? '-' : '+') - 62), static_cast<char>((url ? '_' : '/') - 63),
+        'A', 0, 0);
+    size_t pos = 0;
+    for (; pos + 28 <= in_len; pos += 24) {
+        __m256i in_vec = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + pos))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + pos + 12)), 1);
+        in_vec = _mm256_shuffle_epi8(in_vec, shuffle);
+        const __m256i t0 = _mm256_and_si256(in_vec, _mm256_set1_epi32(0x0fc0fc00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(in_vec, _mm256_set1_epi32(0x003f03f0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        result = _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, result), indices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + pos / 3 * 4), result);
+    }
+    return pos;
+}
+
+ //
+ // Decode: characters are classified with range compares (accepting both
+ // alphabets like pos_of_char), and every 4 six-bit values are packed into
+ // 3 bytes. A group holding anything else ('=', '.', line breaks, invalid
+ // characters) stops the vector loop so the scalar code sees it unchanged.
+ // The 16/32-byte stores carry 12/24 decoded bytes, so the loops stop early
+ // enough that no store reaches past in_len / 4 * 3 bytes of output.
+ //
+__attribute__((target("ssse3")))
+static bool decode_values_ssse3(__m128i chars, __m128i& values) {
+    const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('A' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), chars));
+    const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), chars));
+    const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chars));
+    const __m128i plus  = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('+')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('-')));
+    const __m128i slash = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('/')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('_')));
+    const __m128i symbol = _mm_or_si128(plus, slash);
+    const __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, symbol));
+    if (_mm_movemask_epi8(valid) != 0xffff) return false;
+
+    __m128i shift = _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+                    _mm_or_si128(_mm_and_si128(lower, _mm_set1_epi8(26 - 'a')),
+                                 _mm_and_si128(digit, _mm_set1_epi8(52 - '0'))));
+    values = _mm_add_epi8(chars, shift);
+    values = _mm_or_si128(_mm_andnot_si128(symbol, values),
+                          _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(62)), _mm_and_si128(slash, _mm_set1_epi8(63))));
+    return true;
+}
+
+__attribute__((target("ssse3")))
+static size_t decode_ssse3(const char* in, size_t in_len, char* out) {
+    size_t pos = 0;
+    for (; pos + 24 <= in_len; pos += 16) {
+        __m128i values;
+        if (!decode_values_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + pos)), values)) break;
+        const __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        const __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        const __m128i bytes = _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + pos / 4 * 3), bytes);
+    }
+    return pos;
+}
+
+__attribute__((target("avx2")))
+static size_t decode_avx2(const char* in, size_t in_len, char* out) {
+    size_t pos = 0;
+    for (; pos + 44 <= in_len; pos += 32) {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + pos));
+        const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), chars));
+        const __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), chars));
+        const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+        const __m256i plus  = _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('+')), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('-')));
+        const __m256i slash = _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/')), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('_')));
+        const __m256i symbol = _mm256_or_si256(plus, slash);
+        const __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, symbol));
+        if (_mm256_movemask_epi8(valid) != -1) break;
+
+        __m256i shift = _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+                        _mm256_or_si256(_mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')),
+                                        _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0'))));
+        __m256i values = _mm256_add_epi8(chars, shift);
+        values = _mm256_or_si256(_mm256_andnot_si256(symbol, values),
+                                 _mm256_or_si256(_mm256_and_si256(plus, _mm256_set1_epi8(62)), _mm256_and_si256(slash, _mm256_set1_epi8(63))));
+
+        const __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        const __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        __m256i bytes = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + pos / 4 * 3), bytes);
+    }
+    return pos;
+}
+#endif  // TOYCIPHER_X86_DISPATCH
+
+ //
+ // Encode the whole 3-byte groups of in (in_len / 3 of them) into out and
+ // return the number of bytes consumed.
+ //
+static size_t encode_groups(const unsigned char* in, size_t in_len, char* out, bool url) {
+    const char* base64_chars_ = base64_chars[url];
+    size_t pos = 0;
+
+#ifdef TOYCIPHER_X86_DISPATCH
+    if (CpuFeatures::hasAVX2()) {
+        pos = encode_avx2(in, in_len, out, url);
+    }
+    if (CpuFeatures::hasSSSE3()) {
+        pos += encode_ssse3(in + pos, in_len - pos, out + pos / 3 * 4, url);
+    }
+#endif
+
+    out += pos / 3 * 4;
+    for (; pos + 3 <= in_len; pos += 3) {
+        *out++ = base64_chars_[(in[pos + 0] & 0xfc) >> 2];
+        *out++ = base64_chars_[((in[pos + 0] & 0x03) << 4) + ((in[pos + 1] & 0xf0) >> 4)];
+        *out++ = base64_chars_[((in[pos + 1] & 0x0f) << 2) + ((in[pos + 2] & 0xc0) >> 6)];
+        *out++ = base64_chars_[  in[pos + 2] & 0x3f];
+    }
+    return pos;
+}
+
+ //
+ // Decode whole 4-character groups of in into out for as long as they
+ // contain only base64 characters (no padding, line breaks or invalid
+ // characters) and return the number of characters consumed. Writes
+ // exactly (consumed / 4 * 3) bytes.
+ //
+static size_t decode_groups(const char* in, size_t in_len, char* out) {
+    const unsigned char* table = decode_table();
+    size_t pos = 0;
+
+#ifdef TOYCIPHER_X86_DISPATCH
+    if (CpuFeatures::hasAVX2()) {
+        pos = decode_avx2(in, in_len, out);
+    }
+    if (CpuFeatures::hasSSSE3()) {
+        pos += decode_ssse3(in + pos, in_len - pos, out + pos / 4 * 3);
+    }
+#endif
+
+    out += pos / 4 * 3;
+    for (; pos + 4 <= in_len; pos += 4) {
+        unsigned char a = table[static_cast<unsigned char>(in[pos + 0])];
+        unsigned char b = table[static_cast<unsigned char>(in[pos + 1])];
+        unsigned char c = table[static_cast<unsigned char>(in[pos + 2])];
+        unsigned char d = table[static_cast<unsigned char>(in[pos + 3])];
+        if ((a | b | c | d) == invalid_char) break;
+        *out++ = static_cast<char>((a << 2) | (b >> 4));
+        *out++ = static_cast<char>(((b & 0x0f) << 4) | (c >> 2));
+        *out++ = static_cast<char>(((c & 0x03) << 6) | d);
+    }
+    return pos;
+}
+
 static std::string insert_linebreaks(std::string str, size_t distance) {
  //
  // Provided by https://github.com/JomaCorpFX, adapted by me.
@@ -125,31 +372,38 @@ std::string base64_encode(unsigned char const* bytes_to_encode, size_t in_len, b
  //
     const char* base64_chars_ = base64_chars[url];
 
-    std::string ret;
-    ret.reserve(len_encoded);
+    std::string ret(len_encoded, '\0');
+    char* out = &ret[0];
 
-    unsigned int pos = 0;
+    size_t pos = 0;
+
+ //
+ // Whole 3-byte groups go through encode_groups (vectorized if possible),
+ // the loop below adds the padded last group.
+ //
+    pos = encode_groups(bytes_to_encode, in_len, out, url);
+    out += pos / 3 * 4;
 
     while (pos < in_len) {
-        ret.push_back(base64_chars_[(bytes_to_encode[pos + 0] & 0xfc) >> 2]);
+        *out++ = base64_chars_[(bytes_to_encode[pos + 0] & 0xfc) >> 2];
 
         if (pos+1 < in_len) {
-           ret.push_back(base64_chars_[((bytes_to_encode[pos + 0] & 0x03) << 4) + ((bytes_to_encode[pos + 1] & 0xf0) >> 4)]);
+           *out++ = base64_chars_[((bytes_to_encode[pos + 0] & 0x03) << 4) + ((bytes_to_encode[pos + 1] & 0xf0) >> 4)];
 
            if (pos+2 < in_len) {
-              ret.push_back(base64_chars_[((bytes_to_encode[pos + 1] & 0x0f) << 2) + ((bytes_to_encode[pos + 2] & 0xc0) >> 6)]);
-              ret.push_back(base64_chars_[  bytes_to_encode[pos + 2] & 0x3f]);
+              *out++ = base64_chars_[((bytes_to_encode[pos + 1] & 0x0f) << 2) + ((bytes_to_encode[pos + 2] & 0xc0) >> 6)];
+              *out++ = base64_chars_[  bytes_to_encode[pos + 2] & 0x3f];
            }
            else {
-              ret.push_back(base64_chars_[(bytes_to_encode[pos + 1] & 0x0f) << 2]);
-              ret.push_back(trailing_char);
+              *out++ = base64_chars_[(bytes_to_encode[pos + 1] & 0x0f) << 2];
+              *out++ = trailing_char;
            }
         }
         else {
 
-            ret.push_back(base64_chars_[(bytes_to_encode[pos + 0] & 0x03) << 4]);
-            ret.push_back(trailing_char);
-            ret.push_back(trailing_char);
+            *out++ = base64_chars_[(bytes_to_encode[pos + 0] & 0x03) << 4];
+            *out++ = trailing_char;
+            *out++ = trailing_char;
         }
 
         pos += 3;
@@ -188,6 +442,16 @@ static std::string decode(String const& encoded_string, bool remove_linebreaks)
  //
     size_t approx_length_of_decoded_string = length_of_string / 4 * 3;
     std::string ret;
+
+ //
+ // Decode the bulk of the input with decode_groups (vectorized if possible),
+ // then let the loop below handle whatever is left (padding, line breaks,
+ // invalid characters), appending to the bytes already produced.
+ //
+    ret.resize(approx_length_of_decoded_string);
+    pos = decode_groups(encoded_string.data(), length_of_string, &ret[0]);
+    ret.resize(pos / 4 * 3);
+
     ret.reserve(approx_length_of_decoded_string);
 
     while (pos < length_of_string) {
@@ -279,4 +543,6 @@ std::string base64_decode(std::string_view s, bool remove_linebreaks) {
    return decode(s, remove_linebreaks);
 }
 
-#endif  // __cplusplus >= 201703L
\ No newline at end of file
+#endif  // __cplusplus >= 201703L
+
+#endif  // BASE64_CPP
@@ -0,0 +1,237 @@
+#ifndef BASE64STREAM_H
+#define BASE64STREAM_H
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include "base64.cpp"
+
+using namespace std;
+
+// ========== CODIFICADOR BASE64 POR FLUJO ==========
+// Codifica un flujo de bytes en trozos de cualquier longitud escribiendo en el búfer del
+// llamador. Los 0-2 bytes de un grupo incompleto se guardan para la siguiente llamada y
+// final() escribe el último grupo con relleno. Con lineLength > 0 se inserta '\n' cada
+// lineLength caracteres (64 para PEM, 76 para MIME), igual que base64_encode_pem/mime:
+// sin salto al principio ni al final. La salida concatenada es idéntica a la de
+// base64_encode sobre el mensaje completo.
+class Base64StreamEncoder {
+public:
+    static constexpr size_t PEM_LINE_LENGTH = 64;
+    static constexpr size_t MIME_LINE_LENGTH = 76;
+
+private:
+    bool url;
+    size_t lineLength;
+    unsigned char carry[3];
+    size_t carryLength = 0;
+    size_t column = 0;          // caracteres escritos en la línea actual
+    bool finished = false;
+
+    // Codificar bytes (múltiplo de 3) en output respetando la longitud de línea
+    size_t emitGroups(const unsigned char* data, size_t length, char* output) {
+        if (lineLength == 0) {
+            encode_groups(data, length, output, url);
+            return length / 3 * 4;
+        }
+        size_t written = 0;
+        while (length > 0) {
+            if (column == lineLength) {
+                output[written++] = '\n';
+                column = 0;
+            }
+            size_t take = min(length, (lineLength - column) / 4 * 3);
+            encode_groups(data, take, output + written, url);
+            written += take / 3 * 4;
+            column += take / 3 * 4;
+            data += take;
+            length -= take;
+        }
+        return written;
+    }
+
+    void ensureActive() const {
+        if (finished) {
+            throw runtime_error("El codificador base64 ya fue finalizado");
+        }
+    }
+
+public:
+    explicit Base64StreamEncoder(bool urlSafe = false, size_t charactersPerLine = 0)
+        : url(urlSafe), lineLength(charactersPerLine) {
+        if (lineLength % 4 != 0) {
+            throw invalid_argument("Longitud de linea base64 invalida: debe ser multiplo de 4");
+        }
+    }
+
+    static Base64StreamEncoder pem() {
+        return Base64StreamEncoder(false, PEM_LINE_LENGTH);
+    }
+
+    static Base64StreamEncoder mime() {
+        return Base64StreamEncoder(false, MIME_LINE_LENGTH);
+    }
+
+    // Tamaño de búfer suficiente para update con length bytes de entrada (y para final)
+    size_t maxOutputSize(size_t length) const {
+        size_t characters = (length + 2) / 3 * 4 + 4;
+        return lineLength == 0 ? characters : characters + characters / lineLength + 1;
+    }
+
+    // Codificar un trozo; devuelve los caracteres escritos en output
+    size_t update(const uint8_t* input, size_t length, char* output) {
+        ensureActive();
+        size_t written = 0;
+
+        // Completar el grupo que quedó a medias
+        if (carryLength > 0) {
+            while (carryLength < 3 && length > 0) {
+                carry[carryLength++] = *input++;
+                length--;
+            }
+            if (carryLength < 3) {
+                return 0;
+            }
+            written += emitGroups(carry, 3, output);
+            carryLength = 0;
+        }
+
+        size_t whole = length - length % 3;
+        written += emitGroups(input, whole, output + written);
+        for (size_t i = whole; i < length; i++) {
+            carry[carryLength++] = input[i];
+        }
+        return written;
+    }
+
+    // Escribir el último grupo con relleno (hasta 5 caracteres) y cerrar el flujo
+    size_t final(char* output) {
+        ensureActive();
+        finished = true;
+        if (carryLength == 0) {
+            return 0;
+        }
+        size_t written = 0;
+        if (lineLength != 0 && column == lineLength) {
+            output[written++] = '\n';
+        }
+        string last = base64_encode(carry, carryLength, url);
+        memcpy(output + written, last.data(), last.size());
+        carryLength = 0;
+        return written + last.size();
+    }
+
+    string update(const string& input) {
+        string output(maxOutputSize(input.size()), '\0');
+        output.resize(update(reinterpret_cast<const uint8_t*>(input.data()), input.size(), &output[0]));
+        return output;
+    }
+
+    string final() {
+        char output[8];
+        return string(output, final(output));
+    }
+};
+
+// ========== DECODIFICADOR BASE64 POR FLUJO ==========
+// Decodifica texto base64 en trozos de cualquier longitud. Los saltos de línea ('\n' y '\r')
+// se saltan sobre la marcha, sin copiar la entrada, y los caracteres de un grupo incompleto
+// se guardan para la siguiente llamada. Los tramos entre saltos de línea se decodifican con
+// la ruta vectorial de base64.cpp; el relleno ('=' o '.') y los caracteres inválidos se
+// tratan como en base64_decode.
+class Base64StreamDecoder {
+private:
+    char quad[4];
+    size_t quadLength = 0;
+    bool finished = false;
+
+    // Decodificar un grupo de 2-4 caracteres como el bucle escalar de base64_decode
+    static size_t decodeQuad(const char* group, size_t length, uint8_t* output) {
+        if (length < 2) {
+            throw runtime_error("Input is not valid base64-encoded data.");
+        }
+        unsigned int second = pos_of_char(group[1]);
+        output[0] = static_cast<uint8_t>((pos_of_char(group[0]) << 2) + ((second & 0x30) >> 4));
+        if (length < 3 || group[2] == '=' || group[2] == '.') {
+            return 1;
+        }
+        unsigned int third = pos_of_char(group[2]);
+        output[1] = static_cast<uint8_t>(((second & 0x0f) << 4) + ((third & 0x3c) >> 2));
+        if (length < 4 || group[3] == '=' || group[3] == '.') {
+            return 2;
+        }
+        output[2] = static_cast<uint8_t>(((third & 0x03) << 6) + pos_of_char(group[3]));
+        return 3;
+    }
+
+    void ensureActive() const {
+        if (finished) {
+            throw runtime_error("El decodificador base64 ya fue finalizado");
+        }
+    }
+
+public:
+    Base64StreamDecoder() {}
+
+    // Tamaño de búfer suficiente para update con length caracteres de entrada
+    static size_t maxOutputSize(size_t length) {
+        return (length + 3) / 4 * 3;
+    }
+
+    // Decodificar un trozo; devuelve los bytes escritos en output
+    size_t update(const char* input, size_t length, uint8_t* output) {
+        ensureActive();
+        size_t written = 0;
+        size_t pos = 0;
+        while (pos < length) {
+            // Con el grupo vacío, decodificar en bloque hasta el próximo salto de línea
+            if (quadLength == 0) {
+                const void* newline = memchr(input + pos, '\n', length - pos);
+                size_t runEnd = newline ? static_cast<size_t>(static_cast<const char*>(newline) - input) : length;
+                size_t consumed = decode_groups(input + pos, runEnd - pos, reinterpret_cast<char*>(output + written));
+                written += consumed / 4 * 3;
+                pos += consumed;
+                if (pos == length) {
+                    break;
+                }
+            }
+
+            char c = input[pos++];
+            if (c == '\n' || c == '\r') {
+                continue;
+            }
+            quad[quadLength++] = c;
+            if (quadLength == 4) {
+                written += decodeQuad(quad, 4, output + written);
+                quadLength = 0;
+            }
+        }
+        return written;
+    }
+
+    // Decodificar el grupo final sin relleno (hasta 2 bytes) y cerrar el flujo
+    size_t final(uint8_t* output) {
+        ensureActive();
+        finished = true;
+        if (quadLength == 0) {
+            return 0;
+        }
+        size_t written = decodeQuad(quad, quadLength, output);
+        quadLength = 0;
+        return written;
+    }
+
+    string update(const string& input) {
+        string output(maxOutputSize(input.size()), '\0');
+        output.resize(update(input.data(), input.size(), reinterpret_cast<uint8_t*>(&output[0])));
+        return output;
+    }
+
+    string final() {
+        uint8_t output[3];
+        return string(reinterpret_cast<char*>(output), final(output));
+    }
+};
+
+#endif
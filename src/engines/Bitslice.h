@@ -0,0 +1,271 @@
+#ifndef BITSLICE_H
+#define BITSLICE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include "../Permutation.h"
+#include "../utils/CpuFeatures.h"
+
+using namespace std;
+
+// ========== MOTOR BITSLICED DE LA RED SP ==========
+// El estado de 16 bits de N bloques se transpone a 16 palabras: la palabra b guarda el
+// bit b de cada bloque. La S-box se evalúa como circuito booleano sobre las palabras y
+// la permutación se reduce a renombrar palabras, por lo que el tiempo no depende de los
+// datos ni de la clave. Cada lote procesa 64 bloques con uint64_t, y 256/512 bloques con
+// AVX2/AVX-512 cuando el CPU los soporta. Las llaves de ronda también pueden transponerse,
+// de modo que un mismo lote mezcle bloques cifrados con claves distintas.
+class Bitslice {
+private:
+    // Transponer una matriz de 8x8 bits: el bit k del byte b pasa a ser el bit b del byte k
+    static uint64_t transpose8x8(uint64_t x) {
+        uint64_t t;
+        t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+        x = x ^ t ^ (t << 7);
+        t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+        x = x ^ t ^ (t << 14);
+        t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+        x = x ^ t ^ (t << 28);
+        return x;
+    }
+
+    // Transponer hasta 64 bloques a 16 palabras (slices[b * stride]); los bloques faltantes valen 0
+    static void toSlices(const uint16_t* blocks, size_t count, uint64_t* slices, size_t stride) {
+        for (int b = 0; b < 16; b++) {
+            slices[b * stride] = 0;
+        }
+
+        for (size_t group = 0; group < 8; group++) {
+            uint64_t lowBytes = 0, highBytes = 0;
+            for (size_t k = 0; k < 8; k++) {
+                size_t index = group * 8 + k;
+                uint64_t block = index < count ? blocks[index] : 0;
+                lowBytes |= (block & 0xFF) << (8 * k);
+                highBytes |= (block >> 8) << (8 * k);
+            }
+
+            lowBytes = transpose8x8(lowBytes);
+            highBytes = transpose8x8(highBytes);
+
+            for (int b = 0; b < 8; b++) {
+                slices[b * stride] |= ((lowBytes >> (8 * b)) & 0xFF) << (8 * group);
+                slices[(b + 8) * stride] |= ((highBytes >> (8 * b)) & 0xFF) << (8 * group);
+            }
+        }
+    }
+
+    // Operación inversa de toSlices: reconstruir hasta 64 bloques
+    static void fromSlices(const uint64_t* slices, size_t stride, uint16_t* blocks, size_t count) {
+        for (size_t group = 0; group < 8; group++) {
+            uint64_t lowBytes = 0, highBytes = 0;
+            for (int b = 0; b < 8; b++) {
+                lowBytes |= ((slices[b * stride] >> (8 * group)) & 0xFF) << (8 * b);
+                highBytes |= ((slices[(b + 8) * stride] >> (8 * group)) & 0xFF) << (8 * b);
+            }
+
+            lowBytes = transpose8x8(lowBytes);
+            highBytes = transpose8x8(highBytes);
+
+            for (size_t k = 0; k < 8; k++) {
+                size_t index = group * 8 + k;
+                if (index < count) {
+                    blocks[index] = static_cast<uint16_t>(((lowBytes >> (8 * k)) & 0xFF) |
+                                                          (((highBytes >> (8 * k)) & 0xFF) << 8));
+                }
+            }
+        }
+    }
+
+    // XOR de la llave de ronda: cada bit de la llave se expande a una palabra de ceros o unos
+    template <typename Word>
+    static TOYCIPHER_ALWAYS_INLINE void addRoundKey(Word state[16], uint16_t roundKey) {
+        const Word zero{};
+        for (int b = 0; b < 16; b++) {
+            state[b] ^= zero - static_cast<uint64_t>((roundKey >> b) & 1);
+        }
+    }
+
+    // S-box como circuito: S es afín sobre GF(2) (multiplicar por 7 en GF(2^4) es lineal),
+    // así que cada bit de salida es un XOR de bits de entrada, negado según S(0) = 0xE
+    template <typename Word>
+    static TOYCIPHER_ALWAYS_INLINE void substitute(Word state[16]) {
+        for (int i = 0; i < 16; i += 4) {
+            Word x0 = state[i], x1 = state[i + 1], x2 = state[i + 2], x3 = state[i + 3];
+            state[i]     = x0 ^ x2;
+            state[i + 1] = ~(x0 ^ x1 ^ x2 ^ x3);
+            state[i + 2] = ~(x0 ^ x1 ^ x3);
+            state[i + 3] = ~x1;
+        }
+    }
+
+    // S-box inversa como circuito, S^-1(0) = 0x2
+    template <typename Word>
+    static TOYCIPHER_ALWAYS_INLINE void inverseSubstitute(Word state[16]) {
+        for (int i = 0; i < 16; i += 4) {
+            Word x0 = state[i], x1 = state[i + 1], x2 = state[i + 2], x3 = state[i + 3];
+            state[i]     = x0 ^ x1 ^ x2;
+            state[i + 1] = ~x3;
+            state[i + 2] = x1 ^ x2;
+            state[i + 3] = x0 ^ x1 ^ x3;
+        }
+    }
+
+    // La permutación de bits es solo un renombrado de palabras: con las posiciones
+    // constexpr los índices se resuelven en tiempo de compilación
+    template <typename Word>
+    static TOYCIPHER_ALWAYS_INLINE void permute(Word state[16], const Permutation::PositionArray& positions) {
+        Word permuted[16];
+        for (int b = 0; b < 16; b++) {
+            permuted[b] = state[positions[b]];
+        }
+        for (int b = 0; b < 16; b++) {
+            state[b] = permuted[b];
+        }
+    }
+
+    // XOR de llaves distintas por bloque: se transponen las llaves de ronda igual que los datos
+    template <typename Word, size_t LANES>
+    static TOYCIPHER_ALWAYS_INLINE void addBlockKeys(Word state[16], const uint16_t* const* blockKeys,
+                                                     size_t count, int round) {
+        uint64_t keyLanes[16 * LANES];
+        uint16_t keys[64];
+        for (size_t lane = 0; lane < LANES; lane++) {
+            size_t offset = min(count, lane * 64);
+            size_t laneCount = min<size_t>(64, count - offset);
+            for (size_t i = 0; i < laneCount; i++) {
+                keys[i] = blockKeys[offset + i][round];
+            }
+            toSlices(keys, laneCount, keyLanes + lane, LANES);
+        }
+
+        Word keyState[16];
+        memcpy(keyState, keyLanes, sizeof(keyState));
+        for (int b = 0; b < 16; b++) {
+            state[b] ^= keyState[b];
+        }
+    }
+
+    // Procesar un lote de hasta 64 * LANES bloques con palabras de tipo Word.
+    // Con MULTI_KEY cada bloque i usa sus propias llaves de ronda blockKeys[i]
+    template <typename Word, size_t LANES, bool MULTI_KEY>
+    static TOYCIPHER_ALWAYS_INLINE void processBatch(const uint16_t* input, uint16_t* output, size_t count,
+                                                     const uint16_t* roundKeys, const uint16_t* const* blockKeys,
+                                                     int numRounds, bool decrypt) {
+        uint64_t lanes[16 * LANES];
+        for (size_t lane = 0; lane < LANES; lane++) {
+            size_t offset = min(count, lane * 64);
+            toSlices(input + offset, min<size_t>(64, count - offset), lanes + lane, LANES);
+        }
+
+        Word state[16];
+        memcpy(state, lanes, sizeof(state));
+
+        if (!decrypt) {
+            for (int round = 0; round < numRounds; round++) {
+                if (MULTI_KEY) {
+                    addBlockKeys<Word, LANES>(state, blockKeys, count, round);
+                } else {
+                    addRoundKey(state, roundKeys[round]);
+                }
+                substitute(state);
+                permute(state, Permutation::PERMUTATION);
+            }
+        } else {
+            for (int round = numRounds - 1; round >= 0; round--) {
+                permute(state, Permutation::INVERSE_PERMUTATION);
+                inverseSubstitute(state);
+                if (MULTI_KEY) {
+                    addBlockKeys<Word, LANES>(state, blockKeys, count, round);
+                } else {
+                    addRoundKey(state, roundKeys[round]);
+                }
+            }
+        }
+
+        memcpy(lanes, state, sizeof(state));
+        for (size_t lane = 0; lane < LANES; lane++) {
+            size_t offset = min(count, lane * 64);
+            fromSlices(lanes + lane, LANES, output + offset, min<size_t>(64, count - offset));
+        }
+    }
+
+#ifdef TOYCIPHER_X86_DISPATCH
+    typedef uint64_t Word256 __attribute__((vector_size(32)));
+    typedef uint64_t Word512 __attribute__((vector_size(64)));
+
+    template <bool MULTI_KEY>
+    __attribute__((target("avx2")))
+    static void processBatchAVX2(const uint16_t* input, uint16_t* output, const uint16_t* roundKeys,
+                                 const uint16_t* const* blockKeys, int numRounds, bool decrypt) {
+        processBatch<Word256, 4, MULTI_KEY>(input, output, BATCH_AVX2, roundKeys, blockKeys, numRounds, decrypt);
+    }
+
+    template <bool MULTI_KEY>
+    __attribute__((target("avx512f")))
+    static void processBatchAVX512(const uint16_t* input, uint16_t* output, const uint16_t* roundKeys,
+                                   const uint16_t* const* blockKeys, int numRounds, bool decrypt) {
+        processBatch<Word512, 8, MULTI_KEY>(input, output, BATCH_AVX512, roundKeys, blockKeys, numRounds, decrypt);
+    }
+#endif
+
+    // Recorrer la entrada con el lote más ancho disponible; la cola va en lotes de 64.
+    // Con MULTI_KEY blockKeys avanza junto con los bloques
+    template <bool MULTI_KEY>
+    static void processBlocks(const uint16_t* input, uint16_t* output, size_t count, const uint16_t* roundKeys,
+                              const uint16_t* const* blockKeys, int numRounds, bool decrypt) {
+        size_t done = 0;
+#ifdef TOYCIPHER_X86_DISPATCH
+        if (CpuFeatures::hasAVX512()) {
+            for (; count - done >= BATCH_AVX512; done += BATCH_AVX512) {
+                processBatchAVX512<MULTI_KEY>(input + done, output + done, roundKeys,
+                                              MULTI_KEY ? blockKeys + done : nullptr, numRounds, decrypt);
+            }
+        }
+        if (CpuFeatures::hasAVX2()) {
+            for (; count - done >= BATCH_AVX2; done += BATCH_AVX2) {
+                processBatchAVX2<MULTI_KEY>(input + done, output + done, roundKeys,
+                                            MULTI_KEY ? blockKeys + done : nullptr, numRounds, decrypt);
+            }
+        }
+#endif
+        while (done < count) {
+            size_t batch = min(BATCH_SCALAR, count - done);
+            processBatch<uint64_t, 1, MULTI_KEY>(input + done, output + done, batch, roundKeys,
+                                                 MULTI_KEY ? blockKeys + done : nullptr, numRounds, decrypt);
+            done += batch;
+        }
+    }
+
+public:
+    static constexpr size_t BATCH_SCALAR = 64;
+    static constexpr size_t BATCH_AVX2 = 256;
+    static constexpr size_t BATCH_AVX512 = 512;
+
+    // Cifrar count bloques (input y output pueden coincidir)
+    static void encryptBlocks(const uint16_t* input, uint16_t* output, size_t count,
+                              const uint16_t* roundKeys, int numRounds) {
+        processBlocks<false>(input, output, count, roundKeys, nullptr, numRounds, false);
+    }
+
+    // Descifrar count bloques (input y output pueden coincidir)
+    static void decryptBlocks(const uint16_t* input, uint16_t* output, size_t count,
+                              const uint16_t* roundKeys, int numRounds) {
+        processBlocks<false>(input, output, count, roundKeys, nullptr, numRounds, true);
+    }
+
+    // Cifrar count bloques con llaves distintas por bloque: el bloque i usa blockKeys[i][0..numRounds)
+    static void encryptBlocksMultiKey(const uint16_t* input, uint16_t* output, size_t count,
+                                      const uint16_t* const* blockKeys, int numRounds) {
+        processBlocks<true>(input, output, count, nullptr, blockKeys, numRounds, false);
+    }
+
+    // Descifrar count bloques con llaves distintas por bloque
+    static void decryptBlocksMultiKey(const uint16_t* input, uint16_t* output, size_t count,
+                                      const uint16_t* const* blockKeys, int numRounds) {
+        processBlocks<true>(input, output, count, nullptr, blockKeys, numRounds, true);
+    }
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef BLOCKXOR_H
+#define BLOCKXOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include "../utils/CpuFeatures.h"
+
+#ifdef TOYCIPHER_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// ========== XOR VECTORIAL DE BLOQUES ==========
+// output[i] = a[i] ^ b[i] sobre arreglos de bloques de 16 bits, con registros de
+// 256 bits (AVX2) o 128 bits (SSE2). output puede coincidir con a o con b.
+class BlockXor {
+private:
+#ifdef TOYCIPHER_X86_DISPATCH
+    __attribute__((target("avx2")))
+    static size_t applyAVX2(const uint16_t* a, const uint16_t* b, uint16_t* output, size_t count) {
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_xor_si256(x, y));
+        }
+        return i;
+    }
+
+    __attribute__((target("sse2")))
+    static size_t applySSE2(const uint16_t* a, const uint16_t* b, uint16_t* output, size_t count) {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_xor_si128(x, y));
+        }
+        return i;
+    }
+#endif
+
+public:
+    static void apply(const uint16_t* a, const uint16_t* b, uint16_t* output, size_t count) {
+        size_t done = 0;
+#ifdef TOYCIPHER_X86_DISPATCH
+        if (CpuFeatures::hasAVX2()) {
+            done = applyAVX2(a, b, output, count);
+        } else if (CpuFeatures::hasSSE2()) {
+            done = applySSE2(a, b, output, count);
+        }
+#endif
+        for (; done < count; done++) {
+            output[done] = static_cast<uint16_t>(a[done] ^ b[done]);
+        }
+    }
+};
+
+#endif
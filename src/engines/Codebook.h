@@ -0,0 +1,63 @@
+#ifndef CODEBOOK_H
+#define CODEBOOK_H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ========== CODEBOOK COMPLETO DEL CIFRADOR ==========
+// Con bloques de 16 bits el cifrado completo de una clave cabe en una tabla
+// de 65,536 entradas. Se guardan la tabla de cifrado y su inversa (128 KiB cada una).
+class Codebook {
+private:
+    vector<uint16_t> forwardTable;
+    vector<uint16_t> inverseTable;
+
+public:
+    static constexpr size_t NUM_ENTRIES = 1 << 16;
+
+    // Construir ambas tablas evaluando encryptFn sobre todos los bloques posibles,
+    // repartiendo el espacio entre los hilos disponibles
+    template <typename EncryptFn>
+    explicit Codebook(const EncryptFn& encryptFn)
+        : forwardTable(NUM_ENTRIES), inverseTable(NUM_ENTRIES) {
+        size_t numThreads = max(1u, thread::hardware_concurrency());
+        size_t chunkSize = (NUM_ENTRIES + numThreads - 1) / numThreads;
+
+        auto buildRange = [this, &encryptFn](size_t begin, size_t end) {
+            for (size_t block = begin; block < end; block++) {
+                uint16_t encrypted = encryptFn(static_cast<uint16_t>(block));
+                forwardTable[block] = encrypted;
+                // El cifrado es biyectivo: cada hilo escribe posiciones distintas de la inversa
+                inverseTable[encrypted] = static_cast<uint16_t>(block);
+            }
+        };
+
+        vector<thread> workers;
+        for (size_t begin = chunkSize; begin < NUM_ENTRIES; begin += chunkSize) {
+            workers.emplace_back(buildRange, begin, min(begin + chunkSize, NUM_ENTRIES));
+        }
+        // El hilo actual procesa el primer rango
+        buildRange(0, min(chunkSize, NUM_ENTRIES));
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Cifrar un bloque con una sola consulta
+    uint16_t encrypt(uint16_t block) const {
+        return forwardTable[block];
+    }
+
+    // Descifrar un bloque con una sola consulta
+    uint16_t decrypt(uint16_t block) const {
+        return inverseTable[block];
+    }
+};
+
+#endif
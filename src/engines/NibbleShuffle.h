@@ -0,0 +1,303 @@
+#ifndef NIBBLESHUFFLE_H
+#define NIBBLESHUFFLE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include "../SBox.h"
+#include "../Permutation.h"
+#include "../utils/CpuFeatures.h"
+#include "RoundTables.h"
+
+#ifdef TOYCIPHER_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// ========== MOTOR SIMD CON S-BOX POR SHUFFLE DE NIBBLES ==========
+// La S-box de 16 entradas cabe en un registro de shuffle: PSHUFB sustituye 32 nibbles por
+// instrucción (SSSE3), 64 (AVX2) o 128 (AVX-512BW). Cada bloque ocupa un carril de 16 bits
+// y la permutación se aplica con una secuencia precalculada de desplazamientos y máscaras,
+// agrupando los bits que se mueven la misma distancia. El ancho se elige en tiempo de
+// ejecución; la cola y los CPUs sin SSSE3 usan las tablas de ronda escalares.
+class NibbleShuffle {
+private:
+    static constexpr int MAX_ROUNDS = 16;
+
+    // Secuencia de desplazamientos: salida |= desplazar(entrada, shift) & mask
+    struct ShiftSequence {
+        int length = 0;
+        int shifts[16];      // > 0 desplaza a la derecha, < 0 a la izquierda
+        uint16_t masks[16];
+
+        // Agrupar los bits de destino por distancia recorrida: destino j toma el bit source[j]
+        void build(const int source[16]) {
+            for (int j = 0; j < 16; j++) {
+                int shift = source[j] - j;
+                int group = 0;
+                while (group < length && shifts[group] != shift) {
+                    group++;
+                }
+                if (group == length) {
+                    shifts[length] = shift;
+                    masks[length] = 0;
+                    length++;
+                }
+                masks[group] |= static_cast<uint16_t>(1 << j);
+            }
+        }
+    };
+
+    struct ShuffleTables {
+        // Cada tabla de 16 bytes se repite en los 4 carriles de 128 bits de un registro de 512
+        alignas(64) uint8_t sboxLow[64];       // S(v)
+        alignas(64) uint8_t sboxHigh[64];      // S(v) << 4
+        alignas(64) uint8_t inverseLow[64];    // S^-1(v)
+        alignas(64) uint8_t inverseHigh[64];   // S^-1(v) << 4
+        ShiftSequence forward;
+        ShiftSequence inverse;
+
+        ShuffleTables() {
+            const auto& sbox = SBox::Tables<4>::forward;
+            const auto& inverseSBox = SBox::Tables<4>::inverse;
+
+            for (unsigned int i = 0; i < 64; i++) {
+                unsigned int v = i % 16;
+                sboxLow[i] = sbox[v];
+                sboxHigh[i] = static_cast<uint8_t>(sbox[v] << 4);
+                inverseLow[i] = inverseSBox[v];
+                inverseHigh[i] = static_cast<uint8_t>(inverseSBox[v] << 4);
+            }
+
+            forward.build(Permutation::PERMUTATION.data());
+            inverse.build(Permutation::INVERSE_PERMUTATION.data());
+        }
+    };
+
+    static const ShuffleTables& tables() {
+        static const ShuffleTables shuffleTables;
+        return shuffleTables;
+    }
+
+#ifdef TOYCIPHER_X86_DISPATCH
+    // SSSE3: 8 bloques (32 nibbles) por registro
+    __attribute__((target("ssse3")))
+    static size_t processSSSE3(const uint16_t* input, uint16_t* output, size_t count,
+                               const uint16_t* roundKeys, int numRounds, bool decrypt) {
+        const ShuffleTables& t = tables();
+        const ShiftSequence& sequence = decrypt ? t.inverse : t.forward;
+        const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+        const __m128i lowTable = _mm_load_si128(reinterpret_cast<const __m128i*>(decrypt ? t.inverseLow : t.sboxLow));
+        const __m128i highTable = _mm_load_si128(reinterpret_cast<const __m128i*>(decrypt ? t.inverseHigh : t.sboxHigh));
+
+        __m128i keys[MAX_ROUNDS], masks[16], shifts[16];
+        for (int round = 0; round < numRounds; round++) {
+            keys[round] = _mm_set1_epi16(static_cast<short>(roundKeys[round]));
+        }
+        for (int g = 0; g < sequence.length; g++) {
+            masks[g] = _mm_set1_epi16(static_cast<short>(sequence.masks[g]));
+            shifts[g] = _mm_cvtsi32_si128(sequence.shifts[g] < 0 ? -sequence.shifts[g] : sequence.shifts[g]);
+        }
+
+        size_t done = 0;
+        for (; done + 8 <= count; done += 8) {
+            __m128i state = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + done));
+            for (int step = 0; step < numRounds; step++) {
+                int round = decrypt ? numRounds - 1 - step : step;
+                if (!decrypt) {
+                    state = _mm_xor_si128(state, keys[round]);
+                } else {
+                    __m128i permuted = _mm_setzero_si128();
+                    for (int g = 0; g < sequence.length; g++) {
+                        __m128i moved = sequence.shifts[g] >= 0 ? _mm_srl_epi16(state, shifts[g]) : _mm_sll_epi16(state, shifts[g]);
+                        permuted = _mm_or_si128(permuted, _mm_and_si128(moved, masks[g]));
+                    }
+                    state = permuted;
+                }
+
+                __m128i low = _mm_and_si128(state, nibbleMask);
+                __m128i high = _mm_and_si128(_mm_srli_epi16(state, 4), nibbleMask);
+                state = _mm_or_si128(_mm_shuffle_epi8(lowTable, low), _mm_shuffle_epi8(highTable, high));
+
+                if (!decrypt) {
+                    __m128i permuted = _mm_setzero_si128();
+                    for (int g = 0; g < sequence.length; g++) {
+                        __m128i moved = sequence.shifts[g] >= 0 ? _mm_srl_epi16(state, shifts[g]) : _mm_sll_epi16(state, shifts[g]);
+                        permuted = _mm_or_si128(permuted, _mm_and_si128(moved, masks[g]));
+                    }
+                    state = permuted;
+                } else {
+                    state = _mm_xor_si128(state, keys[round]);
+                }
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + done), state);
+        }
+        return done;
+    }
+
+    // AVX2: 16 bloques (64 nibbles) por registro
+    __attribute__((target("avx2")))
+    static size_t processAVX2(const uint16_t* input, uint16_t* output, size_t count,
+                              const uint16_t* roundKeys, int numRounds, bool decrypt) {
+        const ShuffleTables& t = tables();
+        const ShiftSequence& sequence = decrypt ? t.inverse : t.forward;
+        const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+        const __m256i lowTable = _mm256_load_si256(reinterpret_cast<const __m256i*>(decrypt ? t.inverseLow : t.sboxLow));
+        const __m256i highTable = _mm256_load_si256(reinterpret_cast<const __m256i*>(decrypt ? t.inverseHigh : t.sboxHigh));
+
+        __m256i keys[MAX_ROUNDS], masks[16];
+        __m128i shifts[16];
+        for (int round = 0; round < numRounds; round++) {
+            keys[round] = _mm256_set1_epi16(static_cast<short>(roundKeys[round]));
+        }
+        for (int g = 0; g < sequence.length; g++) {
+            masks[g] = _mm256_set1_epi16(static_cast<short>(sequence.masks[g]));
+            shifts[g] = _mm_cvtsi32_si128(sequence.shifts[g] < 0 ? -sequence.shifts[g] : sequence.shifts[g]);
+        }
+
+        size_t done = 0;
+        for (; done + 16 <= count; done += 16) {
+            __m256i state = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + done));
+            for (int step = 0; step < numRounds; step++) {
+                int round = decrypt ? numRounds - 1 - step : step;
+                if (!decrypt) {
+                    state = _mm256_xor_si256(state, keys[round]);
+                } else {
+                    __m256i permuted = _mm256_setzero_si256();
+                    for (int g = 0; g < sequence.length; g++) {
+                        __m256i moved = sequence.shifts[g] >= 0 ? _mm256_srl_epi16(state, shifts[g]) : _mm256_sll_epi16(state, shifts[g]);
+                        permuted = _mm256_or_si256(permuted, _mm256_and_si256(moved, masks[g]));
+                    }
+                    state = permuted;
+                }
+
+                __m256i low = _mm256_and_si256(state, nibbleMask);
+                __m256i high = _mm256_and_si256(_mm256_srli_epi16(state, 4), nibbleMask);
+                state = _mm256_or_si256(_mm256_shuffle_epi8(lowTable, low), _mm256_shuffle_epi8(highTable, high));
+
+                if (!decrypt) {
+                    __m256i permuted = _mm256_setzero_si256();
+                    for (int g = 0; g < sequence.length; g++) {
+                        __m256i moved = sequence.shifts[g] >= 0 ? _mm256_srl_epi16(state, shifts[g]) : _mm256_sll_epi16(state, shifts[g]);
+                        permuted = _mm256_or_si256(permuted, _mm256_and_si256(moved, masks[g]));
+                    }
+                    state = permuted;
+                } else {
+                    state = _mm256_xor_si256(state, keys[round]);
+                }
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + done), state);
+        }
+        return done;
+    }
+
+    // AVX-512BW: 32 bloques (128 nibbles) por registro
+    __attribute__((target("avx512f,avx512bw")))
+    static size_t processAVX512(const uint16_t* input, uint16_t* output, size_t count,
+                                const uint16_t* roundKeys, int numRounds, bool decrypt) {
+        const ShuffleTables& t = tables();
+        const ShiftSequence& sequence = decrypt ? t.inverse : t.forward;
+        const __m512i nibbleMask = _mm512_set1_epi8(0x0F);
+        const __m512i lowTable = _mm512_load_si512(decrypt ? t.inverseLow : t.sboxLow);
+        const __m512i highTable = _mm512_load_si512(decrypt ? t.inverseHigh : t.sboxHigh);
+
+        __m512i keys[MAX_ROUNDS], masks[16];
+        __m128i shifts[16];
+        for (int round = 0; round < numRounds; round++) {
+            keys[round] = _mm512_set1_epi16(static_cast<short>(roundKeys[round]));
+        }
+        for (int g = 0; g < sequence.length; g++) {
+            masks[g] = _mm512_set1_epi16(static_cast<short>(sequence.masks[g]));
+            shifts[g] = _mm_cvtsi32_si128(sequence.shifts[g] < 0 ? -sequence.shifts[g] : sequence.shifts[g]);
+        }
+
+        size_t done = 0;
+        for (; done + 32 <= count; done += 32) {
+            __m512i state = _mm512_loadu_si512(input + done);
+            for (int step = 0; step < numRounds; step++) {
+                int round = decrypt ? numRounds - 1 - step : step;
+                if (!decrypt) {
+                    state = _mm512_xor_si512(state, keys[round]);
+                } else {
+                    __m512i permuted = _mm512_setzero_si512();
+                    for (int g = 0; g < sequence.length; g++) {
+                        __m512i moved = sequence.shifts[g] >= 0 ? _mm512_srl_epi16(state, shifts[g]) : _mm512_sll_epi16(state, shifts[g]);
+                        permuted = _mm512_or_si512(permuted, _mm512_and_si512(moved, masks[g]));
+                    }
+                    state = permuted;
+                }
+
+                __m512i low = _mm512_and_si512(state, nibbleMask);
+                __m512i high = _mm512_and_si512(_mm512_srli_epi16(state, 4), nibbleMask);
+                state = _mm512_or_si512(_mm512_shuffle_epi8(lowTable, low), _mm512_shuffle_epi8(highTable, high));
+
+                if (!decrypt) {
+                    __m512i permuted = _mm512_setzero_si512();
+                    for (int g = 0; g < sequence.length; g++) {
+                        __m512i moved = sequence.shifts[g] >= 0 ? _mm512_srl_epi16(state, shifts[g]) : _mm512_sll_epi16(state, shifts[g]);
+                        permuted = _mm512_or_si512(permuted, _mm512_and_si512(moved, masks[g]));
+                    }
+                    state = permuted;
+                } else {
+                    state = _mm512_xor_si512(state, keys[round]);
+                }
+            }
+            _mm512_storeu_si512(output + done, state);
+        }
+        return done;
+    }
+#endif
+
+    static void processBlocks(const uint16_t* input, uint16_t* output, size_t count,
+                              const uint16_t* roundKeys, int numRounds, bool decrypt) {
+        if (numRounds > MAX_ROUNDS) {
+            throw invalid_argument("Numero de rondas no soportado por el motor SIMD");
+        }
+
+        size_t done = 0;
+#ifdef TOYCIPHER_X86_DISPATCH
+        if (CpuFeatures::hasAVX512()) {
+            done = processAVX512(input, output, count, roundKeys, numRounds, decrypt);
+        } else if (CpuFeatures::hasAVX2()) {
+            done = processAVX2(input, output, count, roundKeys, numRounds, decrypt);
+        } else if (CpuFeatures::hasSSSE3()) {
+            done = processSSSE3(input, output, count, roundKeys, numRounds, decrypt);
+        }
+#endif
+        if (done == count) {
+            return;
+        }
+
+        // Resto escalar con las tablas de ronda
+        const RoundTables& roundTables = RoundTables::shared();
+        if (!decrypt) {
+            for (; done < count; done++) {
+                output[done] = roundTables.encrypt(input[done], roundKeys, numRounds);
+            }
+        } else {
+            uint16_t decryptKeys[MAX_ROUNDS];
+            for (int round = 0; round < numRounds; round++) {
+                decryptKeys[round] = roundTables.inversePermute(roundKeys[round]);
+            }
+            for (; done < count; done++) {
+                output[done] = roundTables.decrypt(input[done], roundKeys, decryptKeys, numRounds);
+            }
+        }
+    }
+
+public:
+    // Cifrar count bloques (input y output pueden coincidir)
+    static void encryptBlocks(const uint16_t* input, uint16_t* output, size_t count,
+                              const uint16_t* roundKeys, int numRounds) {
+        processBlocks(input, output, count, roundKeys, numRounds, false);
+    }
+
+    // Descifrar count bloques (input y output pueden coincidir)
+    static void decryptBlocks(const uint16_t* input, uint16_t* output, size_t count,
+                              const uint16_t* roundKeys, int numRounds) {
+        processBlocks(input, output, count, roundKeys, numRounds, true);
+    }
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef ROUNDTABLES_H
+#define ROUNDTABLES_H
+
+#include <cstdint>
+#include "../SBox.h"
+#include "../Permutation.h"
+
+using namespace std;
+
+// ========== TABLAS DE RONDA (S-BOX + PERMUTACIÓN FUSIONADAS) ==========
+// La permutación es lineal sobre los bits, así que P(S(n0) | S(n1)<<4 | ...) es el OR
+// de la contribución de cada nibble. Cada tabla guarda, para un nibble de entrada,
+// su salida de S-box ya colocada en las posiciones que ocupa tras la permutación.
+// Las tablas no dependen de la clave y se generan en tiempo de compilación.
+class RoundTables {
+private:
+    uint16_t encryptTables[4][16] = {};            // P(S(v) << 4i)
+    uint16_t decryptTables[4][16] = {};            // P^-1(S^-1(v) << 4i)
+    uint16_t inversePermutationTables[4][16] = {}; // P^-1(v << 4i)
+    uint16_t inverseSBoxTable[16] = {};            // S^-1(v)
+
+    // Las tablas se derivan en tiempo de compilación de las tablas constexpr de SBox y Permutation
+    constexpr RoundTables() {
+        const auto& sbox = SBox::Tables<4>::forward;
+        const auto& inverseSBox = SBox::Tables<4>::inverse;
+
+        for (int i = 0; i < 4; i++) {
+            for (unsigned int v = 0; v < 16; v++) {
+                uint16_t sboxBits = static_cast<uint16_t>(sbox[v] << (4 * i));
+                uint16_t inverseSBoxBits = static_cast<uint16_t>(inverseSBox[v] << (4 * i));
+                uint16_t nibbleBits = static_cast<uint16_t>(v << (4 * i));
+
+                encryptTables[i][v] = Permutation::permuteBits(sboxBits, Permutation::PERMUTATION);
+                decryptTables[i][v] = Permutation::permuteBits(inverseSBoxBits, Permutation::INVERSE_PERMUTATION);
+                inversePermutationTables[i][v] = Permutation::permuteBits(nibbleBits, Permutation::INVERSE_PERMUTATION);
+            }
+        }
+
+        for (unsigned int v = 0; v < 16; v++) {
+            inverseSBoxTable[v] = inverseSBox[v];
+        }
+    }
+
+    // Combinar las cuatro consultas de una tabla por nibble
+    static uint16_t lookup(const uint16_t tables[4][16], uint16_t state) {
+        return tables[0][state & 0xF] |
+               tables[1][(state >> 4) & 0xF] |
+               tables[2][(state >> 8) & 0xF] |
+               tables[3][state >> 12];
+    }
+
+public:
+    RoundTables(const RoundTables&) = delete;
+    RoundTables& operator=(const RoundTables&) = delete;
+
+    // Instancia compartida de solo lectura
+    static const RoundTables& shared() {
+        static constexpr RoundTables tables;
+        return tables;
+    }
+
+    // Aplicar la permutación inversa con consultas por nibble
+    uint16_t inversePermute(uint16_t state) const {
+        return lookup(inversePermutationTables, state);
+    }
+
+    // Cifrar un bloque: por ronda, XOR con la clave y cuatro consultas
+    uint16_t encrypt(uint16_t block, const uint16_t* roundKeys, int numRounds) const {
+        uint16_t state = block;
+        for (int round = 0; round < numRounds; round++) {
+            state = lookup(encryptTables, state ^ roundKeys[round]);
+        }
+        return state;
+    }
+
+    // Descifrar un bloque. Se trabaja con el estado ya permutado a la inversa, de modo que
+    // cada ronda es D(u) ^ P^-1(k); decryptKeys[r] debe contener P^-1(roundKeys[r]).
+    uint16_t decrypt(uint16_t block, const uint16_t* roundKeys, const uint16_t* decryptKeys, int numRounds) const {
+        uint16_t state = inversePermute(block);
+        for (int round = numRounds - 1; round >= 1; round--) {
+            state = lookup(decryptTables, state) ^ decryptKeys[round];
+        }
+
+        // Última ronda: solo S-box inversa y clave, sin permutación
+        uint16_t result = inverseSBoxTable[state & 0xF] |
+                          (inverseSBoxTable[(state >> 4) & 0xF] << 4) |
+                          (inverseSBoxTable[(state >> 8) & 0xF] << 8) |
+                          (inverseSBoxTable[state >> 12] << 12);
+        return result ^ roundKeys[0];
+    }
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef AUTHENTICATEDCTRCIPHER_H
+#define AUTHENTICATEDCTRCIPHER_H
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include "SimpleCipher.cpp"
+#include "WideCTRCipher.cpp"
+#include "PMAC.cpp"
+
+using namespace std;
+
+// ========== CIFRADO AUTENTICADO (CTR ANCHO + PMAC, ENCRYPT-THEN-MAC) ==========
+// El texto plano se cifra con el CTR de contador ancho y el PMAC se calcula sobre el
+// encabezado y el texto cifrado. Al descifrar se verifica el tag antes de tocar el
+// texto cifrado. Las dos pasadas son paralelas y usan el mismo pool y los mismos lotes.
+//
+// La clave del MAC se deriva de la clave maestra como E_k("MA") para no reutilizar
+// la misma permutación en el cifrado y en la autenticación.
+//
+// Formato: encabezado CTR ancho (8 bytes) | texto cifrado | tag (2 bytes, big-endian)
+class AuthenticatedCTRCipher {
+public:
+    static constexpr uint16_t MAC_KEY_LABEL = 0x4D41;
+    static constexpr size_t OVERHEAD = WideCTRCipher::HEADER_SIZE + PMAC::TAG_SIZE;
+
+private:
+    SimpleCipher cipher;
+    WideCTRCipher ctr;
+    PMAC mac;
+
+    SimpleCipher deriveMacCipher() {
+        SimpleCipher macCipher(cipher.encryptBlock(MAC_KEY_LABEL));
+        macCipher.setEngine(cipher.getEngine());
+        return macCipher;
+    }
+
+    void rekey() {
+        ctr.setMasterKeyFromBase64(cipher.getMasterKeyBase64());
+        ctr.setEngine(cipher.getEngine());
+        mac.setCipher(deriveMacCipher());
+    }
+
+public:
+    AuthenticatedCTRCipher() : mac(SimpleCipher(static_cast<uint16_t>(0))) {
+        rekey();
+    }
+
+    // Obtener la clave maestra en formato Base64
+    string getMasterKeyBase64() const {
+        return cipher.getMasterKeyBase64();
+    }
+
+    // Configurar nueva clave desde Base64
+    void setMasterKeyFromBase64(const string& base64Key) {
+        cipher.setMasterKeyFromBase64(base64Key);
+        rekey();
+    }
+
+    // Seleccionar el motor de cifrado de bloques
+    void setEngine(CipherEngine engine) {
+        cipher.setEngine(engine);
+        rekey();
+    }
+
+    // Usar otro pool de hilos (por defecto el compartido del proceso)
+    void setThreadPool(ThreadPool& threadPool) {
+        ctr.setThreadPool(threadPool);
+        mac.setThreadPool(threadPool);
+    }
+
+    // Cifrar length bytes en output (length + OVERHEAD bytes); devuelve los bytes escritos
+    size_t encrypt(const uint8_t* input, size_t length, uint8_t* output) {
+        uint32_t nonce = WideCTRCipher::generateNonce();
+        string header = WideCTRCipher::encodeHeader(nonce);
+        copy(header.begin(), header.end(), output);
+        ctr.applyKeystreamBytes(nonce, 0, input, output + WideCTRCipher::HEADER_SIZE, length);
+
+        size_t macLength = WideCTRCipher::HEADER_SIZE + length;
+        uint16_t tag = mac.computeTag(output, macLength);
+        output[macLength] = static_cast<uint8_t>(tag >> 8);
+        output[macLength + 1] = static_cast<uint8_t>(tag & 0xFF);
+        return macLength + PMAC::TAG_SIZE;
+    }
+
+    // Verificar y descifrar; lanza runtime_error si el tag no coincide
+    size_t decrypt(const uint8_t* input, size_t length, uint8_t* output) {
+        if (length < OVERHEAD) {
+            throw invalid_argument("Datos autenticados invalidos: faltan encabezado o tag");
+        }
+        uint32_t nonce = WideCTRCipher::decodeHeader(input, length);
+        size_t macLength = length - PMAC::TAG_SIZE;
+        uint16_t tag = static_cast<uint16_t>((input[macLength] << 8) | input[macLength + 1]);
+        if (!mac.verify(input, macLength, tag)) {
+            throw runtime_error("Error de autenticacion: el tag no coincide");
+        }
+
+        size_t plaintextLength = length - OVERHEAD;
+        ctr.applyKeystreamBytes(nonce, 0, input + WideCTRCipher::HEADER_SIZE, output, plaintextLength);
+        return plaintextLength;
+    }
+
+    string encrypt(const string& plaintext) {
+        string result(plaintext.size() + OVERHEAD, '\0');
+        encrypt(reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size(),
+                reinterpret_cast<uint8_t*>(&result[0]));
+        return result;
+    }
+
+    string decrypt(const string& data) {
+        if (data.size() < OVERHEAD) {
+            throw invalid_argument("Datos autenticados invalidos: faltan encabezado o tag");
+        }
+        string plaintext(data.size() - OVERHEAD, '\0');
+        decrypt(reinterpret_cast<const uint8_t*>(data.data()), data.size(),
+                reinterpret_cast<uint8_t*>(&plaintext[0]));
+        return plaintext;
+    }
+};
+
+#endif
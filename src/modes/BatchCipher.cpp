@@ -0,0 +1,239 @@
+#ifndef BATCHCIPHER_H
+#define BATCHCIPHER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+#include <openssl/rand.h>
+#include "SimpleCipher.cpp"
+#include "../utils/CryptoUtils.h"
+#include "../utils/ThreadPool.h"
+#include "../engines/Bitslice.h"
+#include "../engines/BlockXor.h"
+
+using namespace std;
+
+// Trabajo independiente de un lote: clave, IV y mensaje (se cifra/descifra en el lugar)
+struct BatchJob {
+    uint16_t masterKey = 0;
+    uint16_t iv = 0;            // CBC usa los 16 bits; CTR solo los 8 bits bajos
+    vector<uint16_t> blocks;
+};
+
+// ========== CIFRADO POR LOTES DE MENSAJES INDEPENDIENTES ==========
+// Muchos mensajes cortos con claves distintas se procesan juntos con el núcleo bitsliced
+// multiclave, que mezcla en un mismo lote bloques de mensajes distintos:
+//  - ECB, CTR y el descifrado CBC no tienen dependencias entre bloques: todos los bloques
+//    de todos los trabajos se aplanan en un solo arreglo con un puntero de llaves por bloque.
+//  - El cifrado CBC es serial dentro de cada mensaje pero no entre mensajes: los trabajos se
+//    ordenan por longitud y la fila t (estructura de arreglos) reúne el bloque t de cada
+//    mensaje que sigue activo, así que cada paso de la cadena llena los carriles SIMD.
+class BatchCipher {
+public:
+    typedef SimpleCipher::Core Core;
+    static const int NUM_ROUNDS = SimpleCipher::NUM_ROUNDS;
+    // Mínimo de bloques (o de trabajos en el cifrado CBC) por hilo al paralelizar
+    static constexpr size_t PARALLEL_MIN_BLOCKS = 16384;
+    static constexpr size_t PARALLEL_MIN_JOBS = 256;
+
+private:
+    ThreadPool* pool = &ThreadPool::shared();
+
+    // Bloques aplanados con la posición de origen y las llaves de cada uno
+    struct FlatBatch {
+        vector<Core> cores;
+        vector<uint16_t> blocks;
+        vector<const uint16_t*> blockKeys;
+        vector<size_t> jobOffsets;
+    };
+
+    static FlatBatch flatten(const vector<BatchJob>& jobs) {
+        FlatBatch flat;
+        flat.cores.reserve(jobs.size());
+        flat.jobOffsets.reserve(jobs.size() + 1);
+        size_t total = 0;
+        for (const auto& job : jobs) {
+            flat.cores.emplace_back(job.masterKey);
+            flat.jobOffsets.push_back(total);
+            total += job.blocks.size();
+        }
+        flat.jobOffsets.push_back(total);
+
+        flat.blocks.reserve(total);
+        flat.blockKeys.reserve(total);
+        for (size_t j = 0; j < jobs.size(); j++) {
+            flat.blocks.insert(flat.blocks.end(), jobs[j].blocks.begin(), jobs[j].blocks.end());
+            flat.blockKeys.insert(flat.blockKeys.end(), jobs[j].blocks.size(), flat.cores[j].getRoundKeys().data());
+        }
+        return flat;
+    }
+
+    // Cifrar o descifrar en lote todos los bloques aplanados, repartidos entre hilos
+    void processFlat(FlatBatch& flat, bool decrypt) {
+        pool->parallelFor(flat.blocks.size(), PARALLEL_MIN_BLOCKS, [&](size_t begin, size_t end) {
+            uint16_t* blocks = flat.blocks.data() + begin;
+            const uint16_t* const* keys = flat.blockKeys.data() + begin;
+            if (decrypt) {
+                Bitslice::decryptBlocksMultiKey(blocks, blocks, end - begin, keys, NUM_ROUNDS);
+            } else {
+                Bitslice::encryptBlocksMultiKey(blocks, blocks, end - begin, keys, NUM_ROUNDS);
+            }
+        });
+    }
+
+    // Generar IVs aleatorios de 16 bits para todos los trabajos de una vez
+    static void generateRandomIVs(vector<BatchJob>& jobs) {
+        vector<unsigned char> randomBytes(jobs.size() * 2);
+        if (!randomBytes.empty() && RAND_bytes(randomBytes.data(), static_cast<int>(randomBytes.size())) != 1) {
+            throw runtime_error("Error: No se pudieron generar IVs con OpenSSL");
+        }
+        for (size_t j = 0; j < jobs.size(); j++) {
+            jobs[j].iv = (static_cast<uint16_t>(randomBytes[2 * j]) << 8) | randomBytes[2 * j + 1];
+        }
+    }
+
+    // El contador CTR de 8 bits solo cubre 256 bloques por trabajo: se rechaza el lote antes de
+    // tocarlo en lugar de repetir el keystream
+    static void ensureCounterRoom(const vector<BatchJob>& jobs) {
+        for (const auto& job : jobs) {
+            CryptoUtils::checkCounterRange(0, job.blocks.size());
+        }
+    }
+
+    // Keystream CTR de cada trabajo en el arreglo aplanado: E_k(IV || contador)
+    void applyKeystream(vector<BatchJob>& jobs) {
+        FlatBatch flat = flatten(jobs);
+        for (size_t j = 0; j < jobs.size(); j++) {
+            uint8_t iv = static_cast<uint8_t>(jobs[j].iv);
+            for (size_t i = 0; i < jobs[j].blocks.size(); i++) {
+                flat.blocks[flat.jobOffsets[j] + i] = CryptoUtils::counterGenerator(iv, static_cast<unsigned int>(i));
+            }
+        }
+        processFlat(flat, false);
+        for (size_t j = 0; j < jobs.size(); j++) {
+            BlockXor::apply(jobs[j].blocks.data(), flat.blocks.data() + flat.jobOffsets[j],
+                            jobs[j].blocks.data(), jobs[j].blocks.size());
+        }
+    }
+
+    // Cadena CBC de un grupo de trabajos ordenados por longitud descendente
+    static void encryptCBCGroup(vector<BatchJob>& jobs, const vector<size_t>& order, size_t begin, size_t end) {
+        size_t groupSize = end - begin;
+        vector<Core> cores;
+        cores.reserve(groupSize);
+        vector<const uint16_t*> keys(groupSize);
+        vector<uint16_t> chain(groupSize);
+        for (size_t a = 0; a < groupSize; a++) {
+            const BatchJob& job = jobs[order[begin + a]];
+            cores.emplace_back(job.masterKey);
+            chain[a] = job.iv;
+        }
+        for (size_t a = 0; a < groupSize; a++) {
+            keys[a] = cores[a].getRoundKeys().data();
+        }
+
+        vector<uint16_t> row(groupSize);
+        size_t active = groupSize;
+        size_t longest = jobs[order[begin]].blocks.size();
+        for (size_t t = 0; t < longest; t++) {
+            // Los trabajos más cortos quedan al final del grupo y van saliendo
+            while (active > 0 && jobs[order[begin + active - 1]].blocks.size() <= t) {
+                active--;
+            }
+            for (size_t a = 0; a < active; a++) {
+                row[a] = static_cast<uint16_t>(jobs[order[begin + a]].blocks[t] ^ chain[a]);
+            }
+            Bitslice::encryptBlocksMultiKey(row.data(), row.data(), active, keys.data(), NUM_ROUNDS);
+            for (size_t a = 0; a < active; a++) {
+                chain[a] = row[a];
+                jobs[order[begin + a]].blocks[t] = row[a];
+            }
+        }
+    }
+
+public:
+    BatchCipher() {}
+
+    // Usar otro pool de hilos (por defecto el compartido del proceso)
+    void setThreadPool(ThreadPool& threadPool) {
+        pool = &threadPool;
+    }
+
+    // ========== ECB ==========
+
+    void encryptECB(vector<BatchJob>& jobs) {
+        FlatBatch flat = flatten(jobs);
+        processFlat(flat, false);
+        for (size_t j = 0; j < jobs.size(); j++) {
+            copy(flat.blocks.begin() + flat.jobOffsets[j], flat.blocks.begin() + flat.jobOffsets[j + 1], jobs[j].blocks.begin());
+        }
+    }
+
+    void decryptECB(vector<BatchJob>& jobs) {
+        FlatBatch flat = flatten(jobs);
+        processFlat(flat, true);
+        for (size_t j = 0; j < jobs.size(); j++) {
+            copy(flat.blocks.begin() + flat.jobOffsets[j], flat.blocks.begin() + flat.jobOffsets[j + 1], jobs[j].blocks.begin());
+        }
+    }
+
+    // ========== CBC ==========
+
+    // Cifrar en modo CBC: se genera un IV aleatorio por trabajo y se guarda en job.iv
+    void encryptCBC(vector<BatchJob>& jobs) {
+        generateRandomIVs(jobs);
+
+        vector<size_t> order(jobs.size());
+        iota(order.begin(), order.end(), size_t(0));
+        stable_sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) {
+            return jobs[a].blocks.size() > jobs[b].blocks.size();
+        });
+
+        // Cada hilo encadena un grupo de trabajos; los grupos no comparten estado
+        pool->parallelFor(order.size(), PARALLEL_MIN_JOBS, [&](size_t begin, size_t end) {
+            encryptCBCGroup(jobs, order, begin, end);
+        });
+    }
+
+    // Descifrar en modo CBC: P[i] = D(C[i]) ^ C[i-1] sin dependencias entre bloques
+    void decryptCBC(vector<BatchJob>& jobs) {
+        FlatBatch flat = flatten(jobs);
+        processFlat(flat, true);
+        for (size_t j = 0; j < jobs.size(); j++) {
+            vector<uint16_t>& blocks = jobs[j].blocks;
+            if (blocks.empty()) {
+                continue;
+            }
+            // XOR con el bloque anterior (o IV para el primer bloque) sobre el arreglo descifrado
+            uint16_t* decrypted = flat.blocks.data() + flat.jobOffsets[j];
+            decrypted[0] ^= jobs[j].iv;
+            BlockXor::apply(decrypted + 1, blocks.data(), decrypted + 1, blocks.size() - 1);
+            copy(decrypted, decrypted + blocks.size(), blocks.begin());
+        }
+    }
+
+    // ========== CTR ==========
+
+    // Cifrar en modo CTR: se genera un IV aleatorio de 8 bits por trabajo y se guarda en job.iv.
+    // Como en CTRCipher, cada trabajo admite como mucho CTR_COUNTER_BLOCKS (256) bloques: si
+    // alguno es más largo se lanza invalid_argument sin modificar el lote.
+    void encryptCTR(vector<BatchJob>& jobs) {
+        ensureCounterRoom(jobs);
+        generateRandomIVs(jobs);
+        for (auto& job : jobs) {
+            job.iv &= 0xFF;
+        }
+        applyKeystream(jobs);
+    }
+
+    // Descifrar en modo CTR con el IV de cada trabajo; mismo límite de 256 bloques por trabajo
+    void decryptCTR(vector<BatchJob>& jobs) {
+        ensureCounterRoom(jobs);
+        applyKeystream(jobs);
+    }
+};
+
+#endif
@@ -6,17 +6,28 @@
 #include <vector>
 #include <bitset>
 #include <random>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
 #include <openssl/rand.h>
 #include "SimpleCipher.cpp"
+#include "../utils/CryptoUtils.h"
+#include "../utils/ThreadPool.h"
+#include "../engines/BlockXor.h"
 
 using namespace std;
 
 class CBCCipher {
+public:
+    // Mínimo de bloques por hilo al paralelizar el descifrado
+    static constexpr size_t PARALLEL_MIN_BLOCKS = 16384;
+
 private:
     SimpleCipher cipher;
+    ThreadPool* pool = &ThreadPool::shared();
 
     // Generar IV aleatorio de 16 bits
-    bitset<16> generateRandomIV() {
+    uint16_t generateRandomIV() {
         unsigned char randomBytes[2]; // 2 bytes = 16 bits
         
         // Generar bytes aleatorios
@@ -25,14 +36,14 @@ private:
             random_device rd;
             mt19937 gen(rd());
             uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
-            return bitset<16>(dis(gen));
+            return dis(gen);
         }
         
         // Convertir los 2 bytes a uint16_t
         uint16_t randomValue = (static_cast<uint16_t>(randomBytes[0]) << 8) | 
                                static_cast<uint16_t>(randomBytes[1]);
         
-        return bitset<16>(randomValue);
+        return randomValue;
     }
 
 public:
@@ -48,55 +59,161 @@ public:
         cipher.setMasterKeyFromBase64(base64Key);
     }
 
+    void setMasterKeyFromBase64(const string& base64Key, KeyCache& keyCache) {
+        cipher.setMasterKeyFromBase64(base64Key, keyCache);
+    }
+
+    // Seleccionar el motor de cifrado de bloques
+    void setEngine(CipherEngine engine) {
+        cipher.setEngine(engine);
+    }
+
+    // Usar otro pool de hilos (por defecto el compartido del proceso)
+    void setThreadPool(ThreadPool& threadPool) {
+        pool = &threadPool;
+    }
+
     // Cifrar en modo CBC
-    pair<bitset<16>, vector<bitset<16>>> encryptCBC(const vector<bitset<16>>& plaintext) {
+    pair<uint16_t, vector<uint16_t>> encryptCBC(const vector<uint16_t>& plaintext) {
         if (plaintext.empty()) {
-            return {bitset<16>(0), vector<bitset<16>>()};
+            return {0, vector<uint16_t>()};
         }
 
-        bitset<16> iv = generateRandomIV();
-        vector<bitset<16>> ciphertext;
-        ciphertext.reserve(plaintext.size());
+        uint16_t iv = generateRandomIV();
+        vector<uint16_t> ciphertext(plaintext.size());
 
-        bitset<16> previousBlock = iv;
+        uint16_t previousBlock = iv;
 
-        for (const auto& block : plaintext) {
-            // XOR con el bloque anterior (o IV para el primer bloque)
-            bitset<16> xorResult = block ^ previousBlock;
-            
-            // Cifrar el resultado
-            bitset<16> encryptedBlock = cipher.encryptBlock(xorResult);
-            ciphertext.push_back(encryptedBlock);
+        for (size_t i = 0; i < plaintext.size(); i++) {
+            // XOR con el bloque anterior (o IV para el primer bloque) y cifrar el resultado
+            ciphertext[i] = cipher.encryptBlock(static_cast<uint16_t>(plaintext[i] ^ previousBlock));
             
             // El bloque cifrado se convierte en el "anterior" para la siguiente iteración
-            previousBlock = encryptedBlock;
+            previousBlock = ciphertext[i];
         }
 
         return {iv, ciphertext};
     }
 
-    // Descifrar en modo CBC
+    pair<bitset<16>, vector<bitset<16>>> encryptCBC(const vector<bitset<16>>& plaintext) {
+        pair<uint16_t, vector<uint16_t>> result = encryptCBC(CryptoUtils::toBlocks16(plaintext));
+        return {bitset<16>(result.first), CryptoUtils::toBitsets(result.second)};
+    }
+
+    // Descifrar count bloques en modo CBC (output no puede coincidir con ciphertext).
+    // P[i] = D(C[i]) ^ C[i-1] solo depende del texto cifrado: cada tramo se descifra en lote
+    // con el motor elegido y se encadena con un XOR vectorial, repartiendo los tramos entre hilos.
+    void decryptCBC(uint16_t iv, const uint16_t* ciphertext, uint16_t* plaintext, size_t count) {
+        cipher.prepare();
+        pool->parallelFor(count, PARALLEL_MIN_BLOCKS, [&](size_t begin, size_t end) {
+            cipher.decryptBlocks(ciphertext + begin, plaintext + begin, end - begin);
+            // XOR con el bloque anterior (o IV para el primer bloque)
+            plaintext[begin] ^= (begin == 0) ? iv : ciphertext[begin - 1];
+            BlockXor::apply(plaintext + begin + 1, ciphertext + begin, plaintext + begin + 1, end - begin - 1);
+        });
+    }
+
+    vector<uint16_t> decryptCBC(uint16_t iv, const vector<uint16_t>& ciphertext) {
+        vector<uint16_t> plaintext(ciphertext.size());
+        decryptCBC(iv, ciphertext.data(), plaintext.data(), ciphertext.size());
+        return plaintext;
+    }
+
     vector<bitset<16>> decryptCBC(const bitset<16>& iv, const vector<bitset<16>>& ciphertext) {
-        if (ciphertext.empty()) {
-            return vector<bitset<16>>();
+        return CryptoUtils::toBitsets(decryptCBC(static_cast<uint16_t>(iv.to_ulong()), CryptoUtils::toBlocks16(ciphertext)));
+    }
+
+    // ========== BYTES (BINARIO, RELLENO PKCS#7) ==========
+
+    // Cifrar length bytes con IV aleatorio (se devuelve en iv) y relleno PKCS#7. output necesita
+    // CryptoUtils::pkcs7PaddedSize(length) bytes y puede coincidir con input.
+    size_t encryptBytes(const uint8_t* input, size_t length, uint8_t* output, uint16_t& iv) {
+        iv = generateRandomIV();
+        uint16_t previousBlock = iv;
+        auto chain = [this, &previousBlock](uint16_t* blocks, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                blocks[i] = cipher.encryptBlock(static_cast<uint16_t>(blocks[i] ^ previousBlock));
+                previousBlock = blocks[i];
+            }
+        };
+
+        size_t fullBlocks = length / CryptoUtils::BLOCK_BYTES;
+        uint16_t finalBlock = CryptoUtils::pkcs7FinalBlock(input + fullBlocks * CryptoUtils::BLOCK_BYTES,
+                                                           length % CryptoUtils::BLOCK_BYTES);
+        CryptoUtils::transformBytes(input, output, fullBlocks, chain);
+        chain(&finalBlock, 1);
+        CryptoUtils::storeBlock(output + fullBlocks * CryptoUtils::BLOCK_BYTES, finalBlock);
+        return CryptoUtils::pkcs7PaddedSize(length);
+    }
+
+    // Descifrar length bytes y quitar el relleno; output puede coincidir con input.
+    // Devuelve la longitud del texto plano.
+    size_t decryptBytes(uint16_t iv, const uint8_t* input, size_t length, uint8_t* output) {
+        if (length == 0 || length % CryptoUtils::BLOCK_BYTES != 0) {
+            throw invalid_argument("Texto cifrado invalido: longitud no es multiplo del bloque");
         }
+        uint16_t previousBlock = iv;
+        CryptoUtils::transformBytes(input, output, length / CryptoUtils::BLOCK_BYTES,
+            [this, &previousBlock](uint16_t* blocks, size_t count) {
+                uint16_t ciphertext[CryptoUtils::BYTE_BATCH_BLOCKS];
+                copy(blocks, blocks + count, ciphertext);
+                cipher.decryptBlocks(blocks, blocks, count);
+                blocks[0] ^= previousBlock;
+                BlockXor::apply(blocks + 1, ciphertext, blocks + 1, count - 1);
+                previousBlock = ciphertext[count - 1];
+            });
+        return CryptoUtils::pkcs7UnpaddedSize(output, length);
+    }
 
-        vector<bitset<16>> plaintext;
-        plaintext.reserve(ciphertext.size());
+#if __cplusplus >= 202002L
+    // Cifrar en el lugar: data debe tener capacidad para el relleno; devuelve el tramo cifrado
+    span<uint8_t> encryptBytes(span<uint8_t> data, size_t length, uint16_t& iv) {
+        if (data.size() < CryptoUtils::pkcs7PaddedSize(length)) {
+            throw invalid_argument("Buffer insuficiente para el relleno PKCS#7");
+        }
+        return data.first(encryptBytes(data.data(), length, data.data(), iv));
+    }
 
-        bitset<16> previousBlock = iv;
+    // Descifrar en el lugar; devuelve el tramo de texto plano sin relleno
+    span<uint8_t> decryptBytes(uint16_t iv, span<uint8_t> data) {
+        return data.first(decryptBytes(iv, data.data(), data.size(), data.data()));
+    }
+#endif
 
-        for (const auto& block : ciphertext) {
-            // Descifrar el bloque
-            bitset<16> decryptedBlock = cipher.decryptBlock(block);
-            
-            // XOR con el bloque anterior (o IV para el primer bloque)
-            bitset<16> originalBlock = decryptedBlock ^ previousBlock;
-            plaintext.push_back(originalBlock);
-            
-            // El bloque cifrado se convierte en el "anterior" para la siguiente iteración
-            previousBlock = block;
-        }        return plaintext;
+    // ========== TUBERÍAS FUSIONADAS CON BASE64 ==========
+
+    // Cifrar texto y codificar los bloques en Base64 en una sola pasada (IV aleatorio en iv)
+    string encryptToBase64(const string& plaintext, uint16_t& iv) {
+        iv = generateRandomIV();
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(plaintext.data());
+        size_t length = plaintext.size();
+        uint16_t previousBlock = iv;
+        return CryptoUtils::blockTilesToBase64(nullptr, 0, (length + 1) / 2,
+            [this, bytes, length, &previousBlock](uint16_t* blocks, size_t start, size_t count) {
+                CryptoUtils::loadBlocks(bytes, length, start, blocks, count);
+                for (size_t i = 0; i < count; i++) {
+                    blocks[i] = cipher.encryptBlock(static_cast<uint16_t>(blocks[i] ^ previousBlock));
+                    previousBlock = blocks[i];
+                }
+            });
+    }
+
+    // Decodificar, descifrar y escribir el texto en una sola pasada
+    string decryptFromBase64(uint16_t iv, const string& base64Data) {
+        string plaintext;
+        plaintext.reserve(base64Data.length() / 4 * 3);
+        uint16_t previousBlock = iv;
+        CryptoUtils::base64ToBlockTiles(base64Data, nullptr, 0,
+            [this, &plaintext, &previousBlock](uint16_t* blocks, size_t count) {
+                uint16_t ciphertext[CryptoUtils::BASE64_TILE_BLOCKS + 1];
+                copy(blocks, blocks + count, ciphertext);
+                cipher.decryptBlocks(blocks, blocks, count);
+                blocks[0] ^= previousBlock;
+                BlockXor::apply(blocks + 1, ciphertext, blocks + 1, count - 1);
+                previousBlock = ciphertext[count - 1];
+                CryptoUtils::appendText(plaintext, blocks, count);
+            });
+        return plaintext;
     }
 };
 
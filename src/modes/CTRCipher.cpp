@@ -6,19 +6,33 @@
 #include <vector>
 #include <bitset>
 #include <random>
+#include <stdexcept>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
 #include <chrono>
 #include <openssl/rand.h>
 #include "SimpleCipher.cpp"
 #include "../utils/CryptoUtils.h"
+#include "../utils/ThreadPool.h"
+#include "../KeystreamCache.h"
+#include "../engines/BlockXor.h"
 
 using namespace std;
 
 class CTRCipher {
+public:
+    // Bloques por lote de keystream y mínimo de bloques por hilo al paralelizar
+    static constexpr size_t KEYSTREAM_BATCH = 1024;
+    static constexpr size_t PARALLEL_MIN_BLOCKS = 16384;
+
 private:
     SimpleCipher cipher;
+    ThreadPool* pool = &ThreadPool::shared();
+    KeystreamCache* keystreamCache = &KeystreamCache::shared();
 
     // Generar IV aleatorio de 16 bits
-    bitset<8> generateRandomIV() {
+    uint8_t generateRandomIV() {
         unsigned char randomBytes[1]; // 1 byte = 8 bits
         
         // Generar bytes aleatorios
@@ -27,15 +41,41 @@ private:
             random_device rd;
             mt19937 gen(rd());
             uniform_int_distribution<uint8_t> dis(0, UINT8_MAX);
-            return bitset<8>(dis(gen));
+            return static_cast<uint8_t>(dis(gen));
         }
         
         // Convertir los 8 bits a uint8_t
         uint8_t randomValue = static_cast<uint8_t>(randomBytes[0]);
         
-        return bitset<8>(randomValue);
+        return randomValue;
     }   
 
+    // Generar el keystream de los bloques [startBlock, startBlock + count): E(IV || contador)
+    void generateKeystream(uint8_t iv, uint64_t startBlock, uint16_t* keystream, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            keystream[i] = CryptoUtils::counterGenerator(iv, static_cast<unsigned int>(startBlock + i));
+        }
+        cipher.encryptBlocks(keystream, keystream, count);
+    }
+
+    // Aplicar el keystream a un tramo contiguo, en lotes que caben en la pila
+    void applyKeystreamRange(uint8_t iv, uint64_t startBlock, const uint16_t* input, uint16_t* output, size_t count) {
+        uint16_t keystream[KEYSTREAM_BATCH];
+        for (size_t done = 0; done < count; done += KEYSTREAM_BATCH) {
+            size_t batch = min(KEYSTREAM_BATCH, count - done);
+            generateKeystream(iv, startBlock + done, keystream, batch);
+            for (size_t i = 0; i < batch; i++) {
+                output[done + i] = static_cast<uint16_t>(input[done + i] ^ keystream[i]);
+            }
+        }
+    }
+
+    // XOR de un tramo (dentro de los 256 bloques del contador) contra el keystream ya materializado
+    static void applyCachedRange(const KeystreamCache::Keystream& keystream, uint64_t startBlock,
+                                 const uint16_t* input, uint16_t* output, size_t count) {
+        BlockXor::apply(input, keystream.data() + startBlock, output, count);
+    }
+
 public:
     CTRCipher() {}
 
@@ -49,61 +89,143 @@ public:
         cipher.setMasterKeyFromBase64(base64Key);
     }
 
-    // Cifrar en modo CTR
-    pair<bitset<8>, vector<bitset<16>>> encryptCTR(const vector<bitset<16>>& plaintext) {
-        if (plaintext.empty()) {
-            return {bitset<8>(0), vector<bitset<16>>()};
+    void setMasterKeyFromBase64(const string& base64Key, KeyCache& keyCache) {
+        cipher.setMasterKeyFromBase64(base64Key, keyCache);
+    }
+
+    // Seleccionar el motor de cifrado de bloques
+    void setEngine(CipherEngine engine) {
+        cipher.setEngine(engine);
+    }
+
+    // Usar otro pool de hilos (por defecto el compartido del proceso)
+    void setThreadPool(ThreadPool& threadPool) {
+        pool = &threadPool;
+    }
+
+    // Usar otro caché de keystreams (por defecto el compartido del proceso); nullptr lo desactiva
+    void setKeystreamCache(KeystreamCache* cache) {
+        keystreamCache = cache;
+    }
+
+    // Cifrar/descifrar count bloques a partir del bloque startBlock del flujo (input y output pueden coincidir).
+    // Permite empezar en cualquier posición sin calcular el keystream anterior; las entradas
+    // grandes se reparten en tramos contiguos de contadores entre los hilos del pool.
+    // El contador de 8 bits solo cubre los bloques 0-255 del mensaje: si startBlock + count pasa
+    // de CTR_COUNTER_BLOCKS se lanza invalid_argument en lugar de repetir el keystream.
+    void applyKeystream(uint8_t iv, uint64_t startBlock, const uint16_t* input, uint16_t* output, size_t count) {
+        CryptoUtils::checkCounterRange(startBlock, count);
+        if (keystreamCache) {
+            shared_ptr<const KeystreamCache::Keystream> keystream = keystreamCache->get(
+                cipher.getMasterKey(), iv, [this, iv](KeystreamCache::Keystream& stream) {
+                    generateKeystream(iv, 0, stream.data(), stream.size());
+                });
+            pool->parallelFor(count, PARALLEL_MIN_BLOCKS, [&](size_t begin, size_t end) {
+                applyCachedRange(*keystream, startBlock + begin, input + begin, output + begin, end - begin);
+            });
+            return;
         }
 
-        bitset<8> iv = generateRandomIV();
-        vector<bitset<16>> ciphertext;
-        ciphertext.reserve(plaintext.size());
-
-        bitset<16> counterBits;
-        int counter = 0;
-        for (const auto& block : plaintext) {
-            // Inicializar el contador con el IV
-            counterBits = CryptoUtils::counterGenerator(iv, counter);
-            // Cifrar el contador
-            bitset<16> encryptedCounter = cipher.encryptBlock(counterBits);
-            
-            // XOR con el bloque de texto plano
-            bitset<16> xorResult = block ^ encryptedCounter;
-            ciphertext.push_back(xorResult);
-            
-            // Incrementar el contador
-            counter++;
+        cipher.prepare();
+        pool->parallelFor(count, PARALLEL_MIN_BLOCKS, [&](size_t begin, size_t end) {
+            applyKeystreamRange(iv, startBlock + begin, input + begin, output + begin, end - begin);
+        });
+    }
+
+    // Cifrar en modo CTR (mensajes de hasta 256 bloques; para más, WideCTRCipher)
+    pair<uint8_t, vector<uint16_t>> encryptCTR(const vector<uint16_t>& plaintext) {
+        if (plaintext.empty()) {
+            return {0, vector<uint16_t>()};
         }
 
+        uint8_t iv = generateRandomIV();
+        vector<uint16_t> ciphertext(plaintext.size());
+        applyKeystream(iv, 0, plaintext.data(), ciphertext.data(), plaintext.size());
+
         return {iv, ciphertext};
     }
 
-    // Descifrar en modo CTR
+    pair<bitset<8>, vector<bitset<16>>> encryptCTR(const vector<bitset<16>>& plaintext) {
+        pair<uint8_t, vector<uint16_t>> result = encryptCTR(CryptoUtils::toBlocks16(plaintext));
+        return {bitset<8>(result.first), CryptoUtils::toBitsets(result.second)};
+    }
+
+    // Descifrar en modo CTR; startBlock indica la posición del primer bloque recibido dentro del mensaje
+    vector<uint16_t> decryptCTR(uint8_t iv, const vector<uint16_t>& ciphertext, uint64_t startBlock = 0) {
+        vector<uint16_t> plaintext(ciphertext.size());
+        applyKeystream(iv, startBlock, ciphertext.data(), plaintext.data(), ciphertext.size());
+        return plaintext;
+    }
+
     vector<bitset<16>> decryptCTR(const bitset<8>& iv, const vector<bitset<16>>& ciphertext) {
-        if (ciphertext.empty()) {
-            return vector<bitset<16>>();
-        }
+        return CryptoUtils::toBitsets(decryptCTR(static_cast<uint8_t>(iv.to_ulong()), CryptoUtils::toBlocks16(ciphertext)));
+    }
 
-        vector<bitset<16>> plaintext;
-        plaintext.reserve(ciphertext.size());
-
-        // Contador inicial
-        bitset<16> counterBits;
-        int counter = 0;
-        for (const auto& block : ciphertext){
-            // Inicializar el contador con el IV
-            counterBits = CryptoUtils::counterGenerator(iv, counter);
-            // Cifrar el contador
-            bitset<16> encryptedCounter = cipher.encryptBlock(counterBits);
-            
-            // XOR con el bloque cifrado
-            bitset<16> xorResult = block ^ encryptedCounter;
-            plaintext.push_back(xorResult);
-            
-            // Incrementar el contador
-            counter++;
+    // ========== BYTES (BINARIO, SIN RELLENO) ==========
+
+    // Aplicar el keystream a length bytes desde el inicio del mensaje (input y output pueden
+    // coincidir). CTR no necesita relleno: el último byte impar usa el byte alto del keystream.
+    void applyKeystreamBytes(uint8_t iv, const uint8_t* input, uint8_t* output, size_t length) {
+        size_t fullBlocks = length / CryptoUtils::BLOCK_BYTES;
+        uint64_t block = 0;
+        CryptoUtils::transformBytes(input, output, fullBlocks, [this, iv, &block](uint16_t* blocks, size_t count) {
+            applyKeystream(iv, block, blocks, blocks, count);
+            block += count;
+        });
+        if (length % CryptoUtils::BLOCK_BYTES != 0) {
+            uint16_t last = static_cast<uint16_t>(input[length - 1] << 8);
+            applyKeystream(iv, fullBlocks, &last, &last, 1);
+            output[length - 1] = static_cast<uint8_t>(last >> 8);
         }
+    }
+
+    // Cifrar length bytes con IV aleatorio (se devuelve en iv); la salida mide lo mismo que la entrada
+    void encryptBytes(const uint8_t* input, size_t length, uint8_t* output, uint8_t& iv) {
+        iv = generateRandomIV();
+        applyKeystreamBytes(iv, input, output, length);
+    }
+
+    void decryptBytes(uint8_t iv, const uint8_t* input, size_t length, uint8_t* output) {
+        applyKeystreamBytes(iv, input, output, length);
+    }
+
+#if __cplusplus >= 202002L
+    // Cifrar en el lugar
+    void encryptBytes(span<uint8_t> data, uint8_t& iv) {
+        encryptBytes(data.data(), data.size(), data.data(), iv);
+    }
+
+    // Descifrar en el lugar
+    void decryptBytes(uint8_t iv, span<uint8_t> data) {
+        decryptBytes(iv, data.data(), data.size(), data.data());
+    }
+#endif
+
+    // ========== TUBERÍAS FUSIONADAS CON BASE64 ==========
+
+    // Cifrar texto y codificar los bloques en Base64 en una sola pasada (IV aleatorio en iv)
+    string encryptToBase64(const string& plaintext, uint8_t& iv) {
+        iv = generateRandomIV();
+        uint8_t counterIV = iv;
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(plaintext.data());
+        size_t length = plaintext.size();
+        return CryptoUtils::blockTilesToBase64(nullptr, 0, (length + 1) / 2,
+            [this, counterIV, bytes, length](uint16_t* blocks, size_t start, size_t count) {
+                CryptoUtils::loadBlocks(bytes, length, start, blocks, count);
+                applyKeystream(counterIV, start, blocks, blocks, count);
+            });
+    }
 
+    // Decodificar, descifrar y escribir el texto en una sola pasada
+    string decryptFromBase64(uint8_t iv, const string& base64Data) {
+        string plaintext;
+        plaintext.reserve(base64Data.length() / 4 * 3);
+        uint64_t block = 0;
+        CryptoUtils::base64ToBlockTiles(base64Data, nullptr, 0, [this, iv, &plaintext, &block](uint16_t* blocks, size_t count) {
+            applyKeystream(iv, block, blocks, blocks, count);
+            block += count;
+            CryptoUtils::appendText(plaintext, blocks, count);
+        });
         return plaintext;
     }
 
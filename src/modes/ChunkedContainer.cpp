@@ -0,0 +1,301 @@
+#ifndef CHUNKEDCONTAINER_H
+#define CHUNKEDCONTAINER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "WideCTRCipher.cpp"
+
+using namespace std;
+
+// ========== CONTENEDOR POR TROZOS CON ÍNDICE ==========
+// Los datos se cifran con el CTR de contador ancho y se guardan en trozos de tamaño fijo
+// (el último puede ser más corto). Cada trozo tiene su propia base de contador: el
+// desplazamiento de su primer byte en el texto plano, de modo que el keystream de un trozo
+// no depende de los demás. Un índice al final del archivo dice dónde está cada trozo, así
+// que un lector puede descifrar cualquier rango de bytes leyendo solo los trozos que lo
+// cubren, y escritor y lector reparten los trozos de una operación entre los hilos.
+//
+// Formato (enteros big-endian):
+//   encabezado: "CK" | versión (1 byte) | reservado (1 byte) | tamaño de trozo (4 bytes) | nonce (4 bytes)
+//   trozos:     texto cifrado de cada trozo, uno tras otro
+//   índice:     por trozo: desplazamiento en el archivo (8) | base de contador (8) | longitud (4)
+//   cierre:     desplazamiento del índice (8) | número de trozos (8) | "CKIX"
+struct ChunkedFormat {
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 12;
+    static constexpr size_t INDEX_ENTRY_SIZE = 20;
+    static constexpr size_t TRAILER_SIZE = 20;
+    static constexpr uint32_t DEFAULT_CHUNK_SIZE = 64 << 10;
+
+    struct ChunkInfo {
+        uint64_t fileOffset;        // posición del trozo cifrado en el archivo
+        uint64_t plaintextOffset;   // base de contador: posición del trozo en el texto plano
+        uint32_t length;
+    };
+
+    static void appendInteger(string& out, uint64_t value, int bytes) {
+        for (int shift = 8 * (bytes - 1); shift >= 0; shift -= 8) {
+            out += static_cast<char>((value >> shift) & 0xFF);
+        }
+    }
+
+    static uint64_t readInteger(const uint8_t* data, int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value = (value << 8) | data[i];
+        }
+        return value;
+    }
+};
+
+// ========== ESCRITOR ==========
+// Recibe el texto plano en trozos de cualquier longitud y escribe el contenedor en un ostream.
+// finish() escribe el último trozo, el índice y el cierre.
+class ChunkedWriter {
+private:
+    WideCTRCipher& cipher;
+    ostream& out;
+    uint32_t chunkSize;
+    uint32_t nonce;
+    string pending;                 // texto plano del trozo en curso
+    uint64_t plaintextOffset = 0;
+    uint64_t fileOffset = 0;
+    vector<ChunkedFormat::ChunkInfo> index;
+    bool finished = false;
+
+    void writeBytes(const string& data) {
+        out.write(data.data(), static_cast<streamsize>(data.size()));
+        if (!out) {
+            throw runtime_error("Error: No se pudo escribir el contenedor cifrado");
+        }
+        fileOffset += data.size();
+    }
+
+    // Cifrar y escribir trozos consecutivos (todos completos salvo quizá el último).
+    // Como la base de contador de cada trozo es su posición en el texto plano, los trozos
+    // contiguos forman un único tramo de keystream que se reparte entre los hilos.
+    void writeChunks(const uint8_t* data, size_t length) {
+        string ciphertext(length, '\0');
+        cipher.applyKeystreamBytes(nonce, plaintextOffset, data, reinterpret_cast<uint8_t*>(&ciphertext[0]), length);
+
+        for (size_t start = 0; start < length; start += chunkSize) {
+            uint32_t chunkLength = static_cast<uint32_t>(min<size_t>(chunkSize, length - start));
+            index.push_back({fileOffset + start, plaintextOffset + start, chunkLength});
+        }
+        writeBytes(ciphertext);
+        plaintextOffset += length;
+    }
+
+public:
+    ChunkedWriter(WideCTRCipher& wideCipher, ostream& output, uint32_t chunkBytes = ChunkedFormat::DEFAULT_CHUNK_SIZE)
+        : cipher(wideCipher), out(output), chunkSize(chunkBytes), nonce(WideCTRCipher::generateNonce()) {
+        if (chunkSize == 0) {
+            throw invalid_argument("Tamano de trozo invalido: debe ser mayor que cero");
+        }
+        string header = "CK";
+        header += static_cast<char>(ChunkedFormat::FORMAT_VERSION);
+        header += '\0';
+        ChunkedFormat::appendInteger(header, chunkSize, 4);
+        ChunkedFormat::appendInteger(header, nonce, 4);
+        writeBytes(header);
+    }
+
+    void write(const uint8_t* data, size_t length) {
+        if (finished) {
+            throw runtime_error("El contenedor ya fue finalizado");
+        }
+        // Completar el trozo en curso
+        if (!pending.empty()) {
+            size_t take = min<size_t>(chunkSize - pending.size(), length);
+            pending.append(reinterpret_cast<const char*>(data), take);
+            data += take;
+            length -= take;
+            if (pending.size() < chunkSize) {
+                return;
+            }
+            writeChunks(reinterpret_cast<const uint8_t*>(pending.data()), pending.size());
+            pending.clear();
+        }
+
+        // Los trozos completos se cifran directamente desde la entrada
+        size_t fullBytes = length - length % chunkSize;
+        if (fullBytes > 0) {
+            writeChunks(data, fullBytes);
+        }
+        pending.assign(reinterpret_cast<const char*>(data + fullBytes), length - fullBytes);
+    }
+
+    void write(const string& data) {
+        write(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    }
+
+    // Escribir el trozo incompleto, el índice y el cierre
+    void finish() {
+        if (finished) {
+            return;
+        }
+        finished = true;
+        if (!pending.empty()) {
+            writeChunks(reinterpret_cast<const uint8_t*>(pending.data()), pending.size());
+            pending.clear();
+        }
+
+        uint64_t indexOffset = fileOffset;
+        string footer;
+        footer.reserve(index.size() * ChunkedFormat::INDEX_ENTRY_SIZE + ChunkedFormat::TRAILER_SIZE);
+        for (const auto& chunk : index) {
+            ChunkedFormat::appendInteger(footer, chunk.fileOffset, 8);
+            ChunkedFormat::appendInteger(footer, chunk.plaintextOffset, 8);
+            ChunkedFormat::appendInteger(footer, chunk.length, 4);
+        }
+        ChunkedFormat::appendInteger(footer, indexOffset, 8);
+        ChunkedFormat::appendInteger(footer, index.size(), 8);
+        footer += "CKIX";
+        writeBytes(footer);
+        out.flush();
+    }
+
+    uint32_t getNonce() const {
+        return nonce;
+    }
+};
+
+// ========== LECTOR ==========
+// Lee el encabezado y el índice de un istream con posicionamiento y descifra rangos de
+// bytes del texto plano leyendo solo los trozos que los cubren.
+class ChunkedReader {
+private:
+    WideCTRCipher& cipher;
+    istream& in;
+    uint32_t chunkSize = 0;
+    uint32_t nonce = 0;
+    uint64_t plaintextSize = 0;
+    vector<ChunkedFormat::ChunkInfo> index;
+
+    void readAt(uint64_t offset, uint8_t* data, size_t length) {
+        in.clear();
+        in.seekg(static_cast<streamoff>(offset));
+        in.read(reinterpret_cast<char*>(data), static_cast<streamsize>(length));
+        if (static_cast<size_t>(in.gcount()) != length) {
+            throw runtime_error("Error: Contenedor cifrado truncado");
+        }
+    }
+
+    void loadIndex() {
+        in.clear();
+        in.seekg(0, ios::end);
+        streamoff fileSize = in.tellg();
+        if (fileSize < static_cast<streamoff>(ChunkedFormat::HEADER_SIZE + ChunkedFormat::TRAILER_SIZE)) {
+            throw invalid_argument("Contenedor invalido: archivo demasiado corto");
+        }
+        uint64_t totalSize = static_cast<uint64_t>(fileSize);
+
+        uint8_t header[ChunkedFormat::HEADER_SIZE];
+        readAt(0, header, sizeof(header));
+        if (header[0] != 'C' || header[1] != 'K') {
+            throw invalid_argument("Contenedor invalido: encabezado ausente");
+        }
+        if (header[2] != ChunkedFormat::FORMAT_VERSION) {
+            throw invalid_argument("Contenedor invalido: version no soportada");
+        }
+        chunkSize = static_cast<uint32_t>(ChunkedFormat::readInteger(header + 4, 4));
+        nonce = static_cast<uint32_t>(ChunkedFormat::readInteger(header + 8, 4));
+
+        uint8_t trailer[ChunkedFormat::TRAILER_SIZE];
+        readAt(totalSize - ChunkedFormat::TRAILER_SIZE, trailer, sizeof(trailer));
+        if (string(reinterpret_cast<char*>(trailer + 16), 4) != "CKIX") {
+            throw invalid_argument("Contenedor invalido: cierre del indice ausente");
+        }
+        uint64_t indexOffset = ChunkedFormat::readInteger(trailer, 8);
+        uint64_t chunkCount = ChunkedFormat::readInteger(trailer + 8, 8);
+        uint64_t indexEnd = totalSize - ChunkedFormat::TRAILER_SIZE;
+        if (indexOffset < ChunkedFormat::HEADER_SIZE || indexOffset > indexEnd ||
+            chunkCount != (indexEnd - indexOffset) / ChunkedFormat::INDEX_ENTRY_SIZE ||
+            (indexEnd - indexOffset) % ChunkedFormat::INDEX_ENTRY_SIZE != 0) {
+            throw invalid_argument("Contenedor invalido: indice corrupto");
+        }
+
+        vector<uint8_t> entries(static_cast<size_t>(indexEnd - indexOffset));
+        readAt(indexOffset, entries.data(), entries.size());
+        index.reserve(static_cast<size_t>(chunkCount));
+        for (size_t i = 0; i < chunkCount; i++) {
+            const uint8_t* entry = entries.data() + i * ChunkedFormat::INDEX_ENTRY_SIZE;
+            ChunkedFormat::ChunkInfo chunk{ChunkedFormat::readInteger(entry, 8),
+                                           ChunkedFormat::readInteger(entry + 8, 8),
+                                           static_cast<uint32_t>(ChunkedFormat::readInteger(entry + 16, 4))};
+            // Los trozos deben ser contiguos en el texto plano y quedar antes del índice
+            if (chunk.plaintextOffset != plaintextSize || chunk.fileOffset < ChunkedFormat::HEADER_SIZE ||
+                chunk.fileOffset + chunk.length > indexOffset) {
+                throw invalid_argument("Contenedor invalido: indice corrupto");
+            }
+            plaintextSize += chunk.length;
+            index.push_back(chunk);
+        }
+    }
+
+public:
+    ChunkedReader(WideCTRCipher& wideCipher, istream& input) : cipher(wideCipher), in(input) {
+        loadIndex();
+    }
+
+    uint64_t size() const {
+        return plaintextSize;
+    }
+
+    uint32_t getChunkSize() const {
+        return chunkSize;
+    }
+
+    const vector<ChunkedFormat::ChunkInfo>& chunks() const {
+        return index;
+    }
+
+    // Descifrar hasta length bytes desde offset en el texto plano; devuelve los bytes escritos
+    size_t read(uint64_t offset, uint8_t* output, size_t length) {
+        if (offset >= plaintextSize || length == 0) {
+            return 0;
+        }
+        length = static_cast<size_t>(min<uint64_t>(length, plaintextSize - offset));
+        uint64_t end = offset + length;
+
+        // Primer trozo que cubre offset
+        auto it = upper_bound(index.begin(), index.end(), offset,
+            [](uint64_t position, const ChunkedFormat::ChunkInfo& chunk) {
+                return position < chunk.plaintextOffset;
+            });
+        size_t first = static_cast<size_t>(it - index.begin()) - 1;
+
+        // Leer solo la parte necesaria de cada trozo
+        for (size_t c = first; c < index.size() && index[c].plaintextOffset < end; c++) {
+            const auto& chunk = index[c];
+            uint64_t from = max(offset, chunk.plaintextOffset);
+            uint64_t to = min(end, chunk.plaintextOffset + chunk.length);
+            readAt(chunk.fileOffset + (from - chunk.plaintextOffset),
+                   output + (from - offset), static_cast<size_t>(to - from));
+        }
+
+        // El keystream es posicional: todo el rango se descifra en paralelo de una vez
+        cipher.applyKeystreamBytes(nonce, offset, output, output, length);
+        return length;
+    }
+
+    string read(uint64_t offset, size_t length) {
+        if (offset >= plaintextSize) {
+            return string();
+        }
+        string result(static_cast<size_t>(min<uint64_t>(length, plaintextSize - offset)), '\0');
+        if (!result.empty()) {
+            read(offset, reinterpret_cast<uint8_t*>(&result[0]), result.size());
+        }
+        return result;
+    }
+
+    string readAll() {
+        return read(0, static_cast<size_t>(plaintextSize));
+    }
+};
+
+#endif
@@ -0,0 +1,589 @@
+#ifndef FILECIPHER_H
+#define FILECIPHER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include "SimpleCipher.cpp"
+#include "StreamingCipher.cpp"
+#include "WideCTRCipher.cpp"
+#include "BatchCipher.cpp"
+#include "../utils/CryptoUtils.h"
+#include "../utils/MappedFile.h"
+#include "../utils/IOError.h"
+#include "../utils/ThreadPool.h"
+#include "../engines/BlockXor.h"
+
+using namespace std;
+
+// ========== CIFRADO DE ARCHIVOS MAPEADOS EN MEMORIA ==========
+// Cifra un archivo entre dos mapeos (entrada y salida reservada de antemano) recorriéndolos
+// por ventanas, así que el tamaño del archivo no está limitado por la RAM ni pasa por
+// iostreams. ECB y CBC usan relleno PKCS#7 como encryptBytes; CTR usa el modo de contador
+// ancho, porque el bloque contador del CTR clásico se repite cada 256 bloques.
+//
+// El mismo formato se produce también desde un flujo (encryptStream/decryptStream, con
+// lecturas y escrituras de STREAM_BUFFER_BYTES) y para registros con prefijo de longitud
+// (encryptRecords/decryptRecords), de modo que un archivo cifrado por cualquier vía se
+// descifra por cualquiera de las otras.
+//
+// Formato: "SF" | versión (1 byte) | modo (1 byte: 0 ECB, 1 CBC, 2 CTR) |
+//          IV (4 bytes, big-endian: 0 en ECB, 16 bits en CBC, nonce de 32 bits en CTR) | datos
+// Registros: longitud (4 bytes, big-endian) | contenido, repetidos hasta el fin del flujo;
+//            cada registro cifrado es un mensaje completo en el formato anterior.
+class FileCipher {
+public:
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 8;
+    static constexpr size_t DEFAULT_WINDOW_BYTES = 64 << 20;
+    // Mínimo de bloques por hilo al paralelizar ECB y el descifrado CBC
+    static constexpr size_t PARALLEL_MIN_BLOCKS = 16384;
+    // Tamaño de las lecturas y escrituras de los flujos (par)
+    static constexpr size_t STREAM_BUFFER_BYTES = 1 << 20;
+    // Los registros se cifran en grupos de hasta estos bytes o registros
+    static constexpr size_t RECORD_PREFIX_SIZE = 4;
+    static constexpr size_t RECORD_GROUP_BYTES = 4 << 20;
+    static constexpr size_t RECORD_GROUP_COUNT = 65536;
+
+private:
+    SimpleCipher cipher;
+    WideCTRCipher ctr;
+    BatchCipher batch;
+    ThreadPool* pool = &ThreadPool::shared();
+    size_t windowBytes = DEFAULT_WINDOW_BYTES;
+
+    static uint16_t loadBlock(const uint8_t* data) {
+        return static_cast<uint16_t>((data[0] << 8) | data[1]);
+    }
+
+    static void encodeHeader(uint8_t* bytes, StreamMode mode, uint32_t iv) {
+        bytes[0] = 'S';
+        bytes[1] = 'F';
+        bytes[2] = FORMAT_VERSION;
+        bytes[3] = static_cast<uint8_t>(mode);
+        for (int i = 0; i < 4; i++) {
+            bytes[4 + i] = static_cast<uint8_t>(iv >> (24 - 8 * i));
+        }
+    }
+
+    static void decodeHeader(const uint8_t* bytes, size_t length, StreamMode& mode, uint32_t& iv) {
+        if (length < HEADER_SIZE || bytes[0] != 'S' || bytes[1] != 'F') {
+            throw invalid_argument("Archivo cifrado invalido: encabezado ausente");
+        }
+        if (bytes[2] != FORMAT_VERSION || bytes[3] > static_cast<uint8_t>(StreamMode::CTR)) {
+            throw invalid_argument("Archivo cifrado invalido: version o modo no soportado");
+        }
+        mode = static_cast<StreamMode>(bytes[3]);
+        iv = (static_cast<uint32_t>(bytes[4]) << 24) | (static_cast<uint32_t>(bytes[5]) << 16) |
+             (static_cast<uint32_t>(bytes[6]) << 8) | static_cast<uint32_t>(bytes[7]);
+    }
+
+    static void rejectSameFile(const MappedFile& input, const string& outputPath) {
+        if (input.isSameFile(outputPath)) {
+            throw invalid_argument("El archivo de salida no puede ser el mismo que el de entrada");
+        }
+    }
+
+    // Crear outputPath y llenarlo con write(output). Si algo falla, el mapeo de salida ya está
+    // cerrado al llegar al catch: se borra el archivo a medio escribir y se relanza el error
+    template <typename WriteFn>
+    static uint64_t writeOutputFile(const string& outputPath, const WriteFn& write) {
+        bool created = false;
+        try {
+            MappedFile output(outputPath, MappedFile::Access::CREATE);
+            created = true;
+            return write(output);
+        } catch (...) {
+            if (created) {
+                remove(outputPath.c_str());
+            }
+            throw;
+        }
+    }
+
+    static void readHeader(MappedFile& input, StreamMode& mode, uint32_t& iv) {
+        if (input.size() < HEADER_SIZE) {
+            throw invalid_argument("Archivo cifrado invalido: encabezado ausente");
+        }
+        MappedFile::Window header = input.map(0, HEADER_SIZE);
+        decodeHeader(header.data(), HEADER_SIZE, mode, iv);
+    }
+
+    // IV aleatorio del tamaño que usa cada modo
+    static uint32_t generateIV(StreamMode mode) {
+        if (mode == StreamMode::CBC) {
+            return WideCTRCipher::generateNonce() & 0xFFFF;
+        }
+        return mode == StreamMode::CTR ? WideCTRCipher::generateNonce() : 0;
+    }
+
+    // ECB sobre blockCount bloques de una ventana, repartidos entre hilos
+    void processECB(const uint8_t* input, uint8_t* output, size_t blockCount, bool decrypt) {
+        cipher.prepare();
+        pool->parallelFor(blockCount, PARALLEL_MIN_BLOCKS, [&](size_t begin, size_t end) {
+            CryptoUtils::transformBytes(input + 2 * begin, output + 2 * begin, end - begin,
+                [this, decrypt](uint16_t* blocks, size_t count) {
+                    if (decrypt) {
+                        cipher.decryptBlocks(blocks, blocks, count);
+                    } else {
+                        cipher.encryptBlocks(blocks, blocks, count);
+                    }
+                });
+        });
+    }
+
+    // Descifrado CBC de una ventana: cada tramo toma el bloque cifrado anterior de la
+    // entrada (o previousBlock al inicio de la ventana), así que los tramos son independientes
+    void decryptCBCWindow(const uint8_t* input, uint8_t* output, size_t blockCount, uint16_t previousBlock) {
+        cipher.prepare();
+        pool->parallelFor(blockCount, PARALLEL_MIN_BLOCKS, [&](size_t begin, size_t end) {
+            uint16_t previous = begin == 0 ? previousBlock : loadBlock(input + 2 * (begin - 1));
+            CryptoUtils::transformBytes(input + 2 * begin, output + 2 * begin, end - begin,
+                [this, &previous](uint16_t* blocks, size_t count) {
+                    uint16_t ciphertext[CryptoUtils::BYTE_BATCH_BLOCKS];
+                    copy(blocks, blocks + count, ciphertext);
+                    cipher.decryptBlocks(blocks, blocks, count);
+                    blocks[0] ^= previous;
+                    BlockXor::apply(blocks + 1, ciphertext, blocks + 1, count - 1);
+                    previous = ciphertext[count - 1];
+                });
+        });
+    }
+
+    // Cifrar count bytes que empiezan en el byte offset de los datos; en ECB y CBC count es par
+    // y previousBlock lleva la cadena CBC de un trozo al siguiente
+    void encryptChunk(StreamMode mode, uint32_t iv, uint64_t offset, const uint8_t* input, uint8_t* output,
+                      size_t count, uint16_t& previousBlock) {
+        switch (mode) {
+            case StreamMode::ECB:
+                processECB(input, output, count / 2, false);
+                break;
+            case StreamMode::CBC:
+                CryptoUtils::transformBytes(input, output, count / 2,
+                    [this, &previousBlock](uint16_t* blocks, size_t blockCount) {
+                        for (size_t i = 0; i < blockCount; i++) {
+                            blocks[i] = cipher.encryptBlock(static_cast<uint16_t>(blocks[i] ^ previousBlock));
+                            previousBlock = blocks[i];
+                        }
+                    });
+                break;
+            case StreamMode::CTR:
+                ctr.applyKeystreamBytes(iv, offset, input, output, count);
+                break;
+        }
+    }
+
+    // Inverso de encryptChunk; input y output no deben coincidir (CBC lee los bloques cifrados anteriores)
+    void decryptChunk(StreamMode mode, uint32_t iv, uint64_t offset, const uint8_t* input, uint8_t* output,
+                      size_t count, uint16_t& previousBlock) {
+        switch (mode) {
+            case StreamMode::ECB:
+                processECB(input, output, count / 2, true);
+                break;
+            case StreamMode::CBC:
+                if (count > 0) {
+                    decryptCBCWindow(input, output, count / 2, previousBlock);
+                    previousBlock = loadBlock(input + count - 2);
+                }
+                break;
+            case StreamMode::CTR:
+                ctr.applyKeystreamBytes(iv, offset, input, output, count);
+                break;
+        }
+    }
+
+    // Último bloque ECB/CBC con el relleno PKCS#7 de los 0-1 bytes sobrantes
+    uint16_t encryptFinalBlock(StreamMode mode, const uint8_t* tail, size_t tailLength, uint16_t previousBlock) {
+        uint16_t finalBlock = CryptoUtils::pkcs7FinalBlock(tail, tailLength);
+        if (mode == StreamMode::CBC) {
+            finalBlock ^= previousBlock;
+        }
+        return cipher.encryptBlock(finalBlock);
+    }
+
+    static size_t readBytes(istream& input, uint8_t* data, size_t length) {
+        input.read(reinterpret_cast<char*>(data), static_cast<streamsize>(length));
+        if (input.bad()) {
+            throw IOError("Error: No se pudo leer la entrada");
+        }
+        return static_cast<size_t>(input.gcount());
+    }
+
+    static void writeBytes(ostream& output, const uint8_t* data, size_t length) {
+        output.write(reinterpret_cast<const char*>(data), static_cast<streamsize>(length));
+        if (!output) {
+            throw IOError("Error: No se pudo escribir la salida");
+        }
+    }
+
+    static void appendLength(vector<uint8_t>& output, size_t length) {
+        if (length > 0xFFFFFFFFu) {
+            throw invalid_argument("Registro invalido: supera el tamano maximo de 4 GiB");
+        }
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            output.push_back(static_cast<uint8_t>(length >> shift));
+        }
+    }
+
+    // Leer el siguiente registro; false si el flujo terminó justo antes de un prefijo
+    static bool readRecord(istream& input, vector<uint8_t>& record) {
+        uint8_t prefix[RECORD_PREFIX_SIZE];
+        size_t got = readBytes(input, prefix, RECORD_PREFIX_SIZE);
+        if (got == 0) {
+            return false;
+        }
+        if (got < RECORD_PREFIX_SIZE) {
+            throw invalid_argument("Registro invalido: prefijo de longitud incompleto");
+        }
+        size_t length = (static_cast<size_t>(prefix[0]) << 24) | (static_cast<size_t>(prefix[1]) << 16) |
+                        (static_cast<size_t>(prefix[2]) << 8) | static_cast<size_t>(prefix[3]);
+        record.resize(length);
+        if (readBytes(input, record.data(), length) != length) {
+            throw invalid_argument("Registro invalido: contenido truncado");
+        }
+        return true;
+    }
+
+    // Leer un grupo de registros para procesarlo de una vez
+    static vector<vector<uint8_t>> readRecordGroup(istream& input) {
+        vector<vector<uint8_t>> records;
+        size_t groupBytes = 0;
+        vector<uint8_t> record;
+        while (records.size() < RECORD_GROUP_COUNT && groupBytes < RECORD_GROUP_BYTES && readRecord(input, record)) {
+            groupBytes += record.size();
+            records.push_back(move(record));
+        }
+        return records;
+    }
+
+public:
+    FileCipher() {
+        ctr.setMasterKeyFromBase64(cipher.getMasterKeyBase64());
+    }
+
+    // Obtener la clave maestra en formato Base64
+    string getMasterKeyBase64() const {
+        return cipher.getMasterKeyBase64();
+    }
+
+    // Configurar nueva clave desde Base64
+    void setMasterKeyFromBase64(const string& base64Key) {
+        cipher.setMasterKeyFromBase64(base64Key);
+        ctr.setMasterKeyFromBase64(base64Key);
+    }
+
+    // Seleccionar el motor de cifrado de bloques
+    void setEngine(CipherEngine engine) {
+        cipher.setEngine(engine);
+        ctr.setEngine(engine);
+    }
+
+    // Usar otro pool de hilos (por defecto el compartido del proceso)
+    void setThreadPool(ThreadPool& threadPool) {
+        pool = &threadPool;
+        ctr.setThreadPool(threadPool);
+    }
+
+    // Tamaño de las ventanas mapeadas (par, para no partir bloques entre ventanas)
+    void setWindowSize(size_t bytes) {
+        if (bytes < 2 || bytes % 2 != 0) {
+            throw invalid_argument("Tamano de ventana invalido: debe ser par y mayor que cero");
+        }
+        windowBytes = bytes;
+    }
+
+    // Convertir "ecb", "cbc" o "ctr" (sin distinguir mayúsculas) al modo correspondiente
+    static StreamMode parseMode(string name) {
+        transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+            return static_cast<char>(toupper(c));
+        });
+        if (name == "ECB") return StreamMode::ECB;
+        if (name == "CBC") return StreamMode::CBC;
+        if (name == "CTR") return StreamMode::CTR;
+        throw invalid_argument("Modo invalido: use ECB, CBC o CTR");
+    }
+
+    // Cifrar inputPath en outputPath (si falla, outputPath no queda); devuelve el tamaño del archivo cifrado
+    uint64_t encryptFile(const string& inputPath, const string& outputPath, StreamMode mode) {
+        MappedFile input(inputPath, MappedFile::Access::READ);
+        rejectSameFile(input, outputPath);
+        return writeOutputFile(outputPath, [&](MappedFile& output) -> uint64_t {
+            uint64_t length = input.size();
+
+            uint32_t iv = generateIV(mode);
+            uint64_t dataSize = mode == StreamMode::CTR ? length : CryptoUtils::pkcs7PaddedSize(static_cast<size_t>(length));
+            output.resize(HEADER_SIZE + dataSize);
+            encodeHeader(output.map(0, HEADER_SIZE).data(), mode, iv);
+
+            uint16_t previousBlock = static_cast<uint16_t>(iv);
+            for (uint64_t offset = 0; offset < length; offset += windowBytes) {
+                size_t count = static_cast<size_t>(min<uint64_t>(windowBytes, length - offset));
+                // ECB y CBC solo procesan aquí los bloques completos; el último va con el relleno
+                size_t outputCount = mode == StreamMode::CTR ? count : count - count % 2;
+                if (outputCount == 0) {
+                    break;
+                }
+                MappedFile::Window in = input.map(offset, outputCount);
+                MappedFile::Window out = output.map(HEADER_SIZE + offset, outputCount);
+                encryptChunk(mode, iv, offset, in.data(), out.data(), outputCount, previousBlock);
+            }
+
+            if (mode != StreamMode::CTR) {
+                uint8_t tail = 0;
+                if (length % 2 != 0) {
+                    tail = input.map(length - 1, 1).data()[0];
+                }
+                MappedFile::Window last = output.map(HEADER_SIZE + length - length % 2, 2);
+                CryptoUtils::storeBlock(last.data(), encryptFinalBlock(mode, &tail, length % 2, previousBlock));
+            }
+            return HEADER_SIZE + dataSize;
+        });
+    }
+
+    // Descifrar inputPath en outputPath (modo e IV del encabezado; si falla, outputPath no queda);
+    // devuelve el tamaño del texto plano
+    uint64_t decryptFile(const string& inputPath, const string& outputPath) {
+        MappedFile input(inputPath, MappedFile::Access::READ);
+        StreamMode mode;
+        uint32_t iv;
+        readHeader(input, mode, iv);
+        rejectSameFile(input, outputPath);
+        uint64_t dataSize = input.size() - HEADER_SIZE;
+        if (mode != StreamMode::CTR && (dataSize == 0 || dataSize % 2 != 0)) {
+            throw invalid_argument("Texto cifrado invalido: longitud no es multiplo del bloque");
+        }
+
+        return writeOutputFile(outputPath, [&](MappedFile& output) -> uint64_t {
+            output.resize(dataSize);
+
+            uint16_t previousBlock = static_cast<uint16_t>(iv);
+            for (uint64_t offset = 0; offset < dataSize; offset += windowBytes) {
+                size_t count = static_cast<size_t>(min<uint64_t>(windowBytes, dataSize - offset));
+                MappedFile::Window in = input.map(HEADER_SIZE + offset, count);
+                MappedFile::Window out = output.map(offset, count);
+                decryptChunk(mode, iv, offset, in.data(), out.data(), count, previousBlock);
+            }
+
+            if (mode == StreamMode::CTR) {
+                return dataSize;
+            }
+            // Quitar el relleno PKCS#7 del último bloque
+            size_t lastBlockBytes;
+            {
+                MappedFile::Window last = output.map(dataSize - 2, 2);
+                lastBlockBytes = CryptoUtils::pkcs7UnpaddedSize(last.data(), 2);
+            }
+            uint64_t plaintextSize = dataSize - 2 + lastBlockBytes;
+            output.resize(plaintextSize);
+            return plaintextSize;
+        });
+    }
+
+    // ========== FLUJOS ==========
+
+    // Cifrar todo input en output con el formato de archivo; devuelve los bytes escritos
+    uint64_t encryptStream(istream& input, ostream& output, StreamMode mode) {
+        uint32_t iv = generateIV(mode);
+        uint8_t header[HEADER_SIZE];
+        encodeHeader(header, mode, iv);
+        writeBytes(output, header, HEADER_SIZE);
+
+        vector<uint8_t> plaintext(STREAM_BUFFER_BYTES);
+        vector<uint8_t> ciphertext(STREAM_BUFFER_BYTES);
+        uint16_t previousBlock = static_cast<uint16_t>(iv);
+        uint64_t offset = 0;
+        bool last = false;
+        while (!last) {
+            size_t count = readBytes(input, plaintext.data(), plaintext.size());
+            last = count < plaintext.size();
+            // Solo la última lectura puede dejar un byte suelto; cabe junto al relleno porque count < tamaño
+            size_t processed = mode == StreamMode::CTR || !last ? count : count - count % 2;
+            encryptChunk(mode, iv, offset, plaintext.data(), ciphertext.data(), processed, previousBlock);
+            offset += processed;
+            if (last && mode != StreamMode::CTR) {
+                CryptoUtils::storeBlock(ciphertext.data() + processed,
+                                        encryptFinalBlock(mode, plaintext.data() + processed, count % 2, previousBlock));
+                processed += 2;
+            }
+            writeBytes(output, ciphertext.data(), processed);
+        }
+        output.flush();
+        return HEADER_SIZE + (mode == StreamMode::CTR ? offset : offset + 2);
+    }
+
+    // Descifrar todo input en output (modo e IV del encabezado); devuelve los bytes escritos
+    uint64_t decryptStream(istream& input, ostream& output) {
+        uint8_t header[HEADER_SIZE];
+        StreamMode mode;
+        uint32_t iv;
+        decodeHeader(header, readBytes(input, header, HEADER_SIZE), mode, iv);
+
+        vector<uint8_t> ciphertext(STREAM_BUFFER_BYTES);
+        vector<uint8_t> plaintext(STREAM_BUFFER_BYTES);
+        uint16_t previousBlock = static_cast<uint16_t>(iv);
+        uint64_t offset = 0;
+        uint64_t written = 0;
+        // ECB/CBC: el último bloque descifrado se retiene hasta saber si lleva el relleno
+        uint8_t heldBlock[2];
+        bool holding = false;
+        bool last = false;
+        while (!last) {
+            size_t count = readBytes(input, ciphertext.data(), ciphertext.size());
+            last = count < ciphertext.size();
+            if (mode != StreamMode::CTR && count % 2 != 0) {
+                throw invalid_argument("Texto cifrado invalido: longitud no es multiplo del bloque");
+            }
+            decryptChunk(mode, iv, offset, ciphertext.data(), plaintext.data(), count, previousBlock);
+            offset += count;
+            if (mode == StreamMode::CTR) {
+                writeBytes(output, plaintext.data(), count);
+                written += count;
+            } else if (count > 0) {
+                if (holding) {
+                    writeBytes(output, heldBlock, 2);
+                    written += 2;
+                }
+                writeBytes(output, plaintext.data(), count - 2);
+                written += count - 2;
+                copy(plaintext.data() + count - 2, plaintext.data() + count, heldBlock);
+                holding = true;
+            }
+        }
+
+        if (mode != StreamMode::CTR) {
+            if (!holding) {
+                throw invalid_argument("Texto cifrado invalido: longitud no es multiplo del bloque");
+            }
+            size_t lastBlockBytes = CryptoUtils::pkcs7UnpaddedSize(heldBlock, 2);
+            writeBytes(output, heldBlock, lastBlockBytes);
+            written += lastBlockBytes;
+        }
+        output.flush();
+        return written;
+    }
+
+    // ========== REGISTROS CON PREFIJO DE LONGITUD ==========
+
+    // Cifrar cada registro de input como un mensaje independiente con su propio IV; los registros
+    // ECB/CBC de un grupo se cifran juntos con BatchCipher. Devuelve el número de registros.
+    uint64_t encryptRecords(istream& input, ostream& output, StreamMode mode) {
+        uint64_t total = 0;
+        vector<uint8_t> encoded;
+        while (true) {
+            vector<vector<uint8_t>> records = readRecordGroup(input);
+            if (records.empty()) {
+                break;
+            }
+            encoded.clear();
+
+            if (mode == StreamMode::CTR) {
+                for (const auto& record : records) {
+                    uint32_t nonce = generateIV(mode);
+                    appendLength(encoded, HEADER_SIZE + record.size());
+                    size_t start = encoded.size();
+                    encoded.resize(start + HEADER_SIZE + record.size());
+                    encodeHeader(encoded.data() + start, mode, nonce);
+                    ctr.applyKeystreamBytes(nonce, 0, record.data(), encoded.data() + start + HEADER_SIZE, record.size());
+                }
+            } else {
+                vector<BatchJob> jobs(records.size());
+                for (size_t j = 0; j < records.size(); j++) {
+                    const vector<uint8_t>& record = records[j];
+                    size_t fullBlocks = record.size() / 2;
+                    jobs[j].masterKey = cipher.getMasterKey();
+                    jobs[j].blocks.resize(fullBlocks + 1);
+                    CryptoUtils::loadBlocks(record.data(), record.size(), 0, jobs[j].blocks.data(), fullBlocks);
+                    jobs[j].blocks[fullBlocks] = CryptoUtils::pkcs7FinalBlock(record.data() + 2 * fullBlocks, record.size() % 2);
+                }
+                if (mode == StreamMode::ECB) {
+                    batch.encryptECB(jobs);
+                } else {
+                    batch.encryptCBC(jobs);
+                }
+                for (const auto& job : jobs) {
+                    appendLength(encoded, HEADER_SIZE + 2 * job.blocks.size());
+                    size_t start = encoded.size();
+                    encoded.resize(start + HEADER_SIZE + 2 * job.blocks.size());
+                    encodeHeader(encoded.data() + start, mode, mode == StreamMode::CBC ? job.iv : 0);
+                    for (size_t i = 0; i < job.blocks.size(); i++) {
+                        CryptoUtils::storeBlock(encoded.data() + start + HEADER_SIZE + 2 * i, job.blocks[i]);
+                    }
+                }
+            }
+            writeBytes(output, encoded.data(), encoded.size());
+            total += records.size();
+        }
+        output.flush();
+        return total;
+    }
+
+    // Descifrar registros producidos por encryptRecords (cada uno con su modo e IV);
+    // devuelve el número de registros
+    uint64_t decryptRecords(istream& input, ostream& output) {
+        uint64_t total = 0;
+        vector<uint8_t> encoded;
+        while (true) {
+            vector<vector<uint8_t>> records = readRecordGroup(input);
+            if (records.empty()) {
+                break;
+            }
+
+            // Los registros ECB y CBC del grupo se descifran juntos; los CTR uno por uno
+            vector<StreamMode> modes(records.size());
+            vector<BatchJob> ecbJobs, cbcJobs;
+            vector<size_t> jobIndex(records.size());
+            for (size_t j = 0; j < records.size(); j++) {
+                const vector<uint8_t>& record = records[j];
+                uint32_t iv;
+                decodeHeader(record.data(), record.size(), modes[j], iv);
+                size_t dataSize = record.size() - HEADER_SIZE;
+                if (modes[j] == StreamMode::CTR) {
+                    ctr.applyKeystreamBytes(iv, 0, record.data() + HEADER_SIZE, records[j].data() + HEADER_SIZE, dataSize);
+                    continue;
+                }
+                if (dataSize == 0 || dataSize % 2 != 0) {
+                    throw invalid_argument("Texto cifrado invalido: longitud no es multiplo del bloque");
+                }
+                BatchJob job;
+                job.masterKey = cipher.getMasterKey();
+                job.iv = static_cast<uint16_t>(iv);
+                job.blocks.resize(dataSize / 2);
+                CryptoUtils::loadBlocks(record.data() + HEADER_SIZE, dataSize, 0, job.blocks.data(), dataSize / 2);
+                vector<BatchJob>& jobs = modes[j] == StreamMode::ECB ? ecbJobs : cbcJobs;
+                jobIndex[j] = jobs.size();
+                jobs.push_back(move(job));
+            }
+            batch.decryptECB(ecbJobs);
+            batch.decryptCBC(cbcJobs);
+
+            encoded.clear();
+            for (size_t j = 0; j < records.size(); j++) {
+                if (modes[j] == StreamMode::CTR) {
+                    appendLength(encoded, records[j].size() - HEADER_SIZE);
+                    encoded.insert(encoded.end(), records[j].begin() + HEADER_SIZE, records[j].end());
+                    continue;
+                }
+                const vector<uint16_t>& blocks = (modes[j] == StreamMode::ECB ? ecbJobs : cbcJobs)[jobIndex[j]].blocks;
+                size_t start = encoded.size() + RECORD_PREFIX_SIZE;
+                encoded.resize(start + 2 * blocks.size());
+                for (size_t i = 0; i < blocks.size(); i++) {
+                    CryptoUtils::storeBlock(encoded.data() + start + 2 * i, blocks[i]);
+                }
+                size_t plaintextSize = 2 * blocks.size() - 2 + CryptoUtils::pkcs7UnpaddedSize(encoded.data() + encoded.size() - 2, 2);
+                encoded.resize(start + plaintextSize);
+                for (int i = 0; i < 4; i++) {
+                    encoded[start - RECORD_PREFIX_SIZE + i] = static_cast<uint8_t>(plaintextSize >> (24 - 8 * i));
+                }
+            }
+            writeBytes(output, encoded.data(), encoded.size());
+            total += records.size();
+        }
+        output.flush();
+        return total;
+    }
+};
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef MULTILANECBCCIPHER_H
+#define MULTILANECBCCIPHER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <stdexcept>
+#include <openssl/rand.h>
+#include "SimpleCipher.cpp"
+#include "../utils/ThreadPool.h"
+#include "../engines/BlockXor.h"
+
+using namespace std;
+
+// ========== MODO CBC MULTICARRIL ==========
+// El mensaje se reparte en N carriles entrelazados: el bloque i pertenece al carril i % N
+// y se encadena con el bloque i - N, es decir C[i] = E(P[i] ^ C[i - N]). Cada carril
+// arranca con su propio IV derivado del IV base como E(IV ^ carril). Los N bloques de
+// una fila son independientes y se cifran juntos con el motor por lotes.
+//
+// Formato: carriles (2 bytes, big-endian) | IV base (2 bytes, big-endian) | bloques.
+class MultiLaneCBCCipher {
+public:
+    static constexpr uint16_t DEFAULT_LANES = 64;
+    static constexpr uint16_t MAX_LANES = 4096;
+    // Mínimo de bloques por hilo al paralelizar el descifrado
+    static constexpr size_t PARALLEL_MIN_BLOCKS = 16384;
+
+    struct Message {
+        uint16_t laneCount;
+        uint16_t iv;
+        vector<uint16_t> blocks;
+    };
+
+private:
+    SimpleCipher cipher;
+    uint16_t laneCount;
+    ThreadPool* pool = &ThreadPool::shared();
+
+    static void validateLaneCount(uint16_t lanes) {
+        if (lanes < 1 || lanes > MAX_LANES) {
+            throw invalid_argument("Numero de carriles invalido: debe estar entre 1 y " + to_string(MAX_LANES));
+        }
+    }
+
+    // Generar IV aleatorio de 16 bits
+    uint16_t generateRandomIV() {
+        unsigned char randomBytes[2]; // 2 bytes = 16 bits
+
+        // Generar bytes aleatorios
+        if (RAND_bytes(randomBytes, 2) != 1) {
+            // Si falla, usar fallback con random_device
+            random_device rd;
+            mt19937 gen(rd());
+            uniform_int_distribution<uint16_t> dis(0, UINT16_MAX);
+            return dis(gen);
+        }
+
+        return (static_cast<uint16_t>(randomBytes[0]) << 8) |
+               static_cast<uint16_t>(randomBytes[1]);
+    }
+
+    // IV de cada carril: E(IV ^ carril), distintos entre sí porque E es una permutación
+    vector<uint16_t> deriveLaneIVs(uint16_t iv, uint16_t lanes) {
+        vector<uint16_t> laneIVs(lanes);
+        for (uint16_t lane = 0; lane < lanes; lane++) {
+            laneIVs[lane] = static_cast<uint16_t>(iv ^ lane);
+        }
+        cipher.encryptBlocks(laneIVs.data(), laneIVs.data(), lanes);
+        return laneIVs;
+    }
+
+public:
+    explicit MultiLaneCBCCipher(uint16_t lanes = DEFAULT_LANES) : laneCount(lanes) {
+        validateLaneCount(lanes);
+    }
+
+    // Obtener la clave maestra en formato Base64
+    string getMasterKeyBase64() const {
+        return cipher.getMasterKeyBase64();
+    }
+
+    // Configurar nueva clave desde Base64
+    void setMasterKeyFromBase64(const string& base64Key) {
+        cipher.setMasterKeyFromBase64(base64Key);
+    }
+
+    void setMasterKeyFromBase64(const string& base64Key, KeyCache& keyCache) {
+        cipher.setMasterKeyFromBase64(base64Key, keyCache);
+    }
+
+    // Seleccionar el motor de cifrado de bloques
+    void setEngine(CipherEngine engine) {
+        cipher.setEngine(engine);
+    }
+
+    // Usar otro pool de hilos (por defecto el compartido del proceso)
+    void setThreadPool(ThreadPool& threadPool) {
+        pool = &threadPool;
+    }
+
+    // Número de carriles para los próximos cifrados (el descifrado usa el del mensaje)
+    void setLaneCount(uint16_t lanes) {
+        validateLaneCount(lanes);
+        laneCount = lanes;
+    }
+
+    uint16_t getLaneCount() const {
+        return laneCount;
+    }
+
+    // Cifrar fila por fila: cada fila de N bloques se encadena con la anterior y se cifra en lote
+    Message encrypt(const vector<uint16_t>& plaintext) {
+        Message message{laneCount, generateRandomIV(), vector<uint16_t>(plaintext.size())};
+        vector<uint16_t> laneIVs = deriveLaneIVs(message.iv, laneCount);
+
+        const uint16_t* previousRow = laneIVs.data();
+        for (size_t start = 0; start < plaintext.size(); start += laneCount) {
+            size_t rowSize = min<size_t>(laneCount, plaintext.size() - start);
+            uint16_t* row = message.blocks.data() + start;
+            BlockXor::apply(plaintext.data() + start, previousRow, row, rowSize);
+            cipher.encryptBlocks(row, row, rowSize);
+            previousRow = row;
+        }
+
+        return message;
+    }
+
+    // Descifrar: P[i] = D(C[i]) ^ C[i - N] depende solo del texto cifrado, así que
+    // se descifra en lote por tramos repartidos entre hilos
+    vector<uint16_t> decrypt(const Message& message) {
+        validateLaneCount(message.laneCount);
+        const size_t lanes = message.laneCount;
+        const vector<uint16_t>& ciphertext = message.blocks;
+        vector<uint16_t> plaintext(ciphertext.size());
+        vector<uint16_t> laneIVs = deriveLaneIVs(message.iv, message.laneCount);
+
+        cipher.prepare();
+        pool->parallelFor(ciphertext.size(), PARALLEL_MIN_BLOCKS, [&](size_t begin, size_t end) {
+            cipher.decryptBlocks(ciphertext.data() + begin, plaintext.data() + begin, end - begin);
+            // La primera fila se encadena con los IVs de carril, el resto con la fila anterior
+            size_t firstRowEnd = max(begin, min(end, lanes));
+            if (begin < firstRowEnd) {
+                BlockXor::apply(plaintext.data() + begin, laneIVs.data() + begin,
+                                plaintext.data() + begin, firstRowEnd - begin);
+            }
+            if (firstRowEnd < end) {
+                BlockXor::apply(plaintext.data() + firstRowEnd, ciphertext.data() + firstRowEnd - lanes,
+                                plaintext.data() + firstRowEnd, end - firstRowEnd);
+            }
+        });
+
+        return plaintext;
+    }
+
+    // ========== SERIALIZACIÓN ==========
+
+    static string toBase64(const Message& message) {
+        string binaryData;
+        binaryData.reserve(4 + message.blocks.size() * 2);
+        CryptoUtils::appendBlock(binaryData, message.laneCount);
+        CryptoUtils::appendBlock(binaryData, message.iv);
+        for (uint16_t block : message.blocks) {
+            CryptoUtils::appendBlock(binaryData, block);
+        }
+        return base64_encode(binaryData);
+    }
+
+    static Message fromBase64(const string& base64Data) {
+        string decodedData = base64_decode(base64Data);
+
+        if (decodedData.length() < 4) {
+            throw invalid_argument("Datos insuficientes para extraer carriles e IV");
+        }
+
+        Message message{CryptoUtils::readBlock(decodedData, 0), CryptoUtils::readBlock(decodedData, 2), {}};
+        validateLaneCount(message.laneCount);
+
+        message.blocks.reserve((decodedData.length() - 3) / 2);
+        for (size_t i = 4; i < decodedData.length(); i += 2) {
+            message.blocks.push_back(CryptoUtils::readBlock(decodedData, i));
+        }
+        return message;
+    }
+};
+
+#endif
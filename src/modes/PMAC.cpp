@@ -0,0 +1,150 @@
+#ifndef PMAC_H
+#define PMAC_H
+
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <algorithm>
+#include <openssl/crypto.h>
+#include "SimpleCipher.cpp"
+#include "../utils/ThreadPool.h"
+
+using namespace std;
+
+// ========== MAC PARALELIZABLE (ESTILO PMAC) ==========
+// A diferencia de CBC-MAC, cada bloque se cifra de forma independiente tras enmascararlo
+// con un desplazamiento que depende solo de su posición:
+//   Σ = XOR_i E(M_i ^ Δ_i)  para todos los bloques salvo el último
+//   Σ ^= M_m ^ L·x⁻¹  si el último bloque está completo, o pad(M_m) = M_m || 1 0* si no
+//   tag = E(Σ)
+// con L = E(0) y Δ_i = γ_i · L en GF(2^16) (polinomio x^16 + x^5 + x^3 + x^2 + 1), donde γ_i
+// es el código Gray de i. Como γ_i y γ_{i-1} difieren en el bit ntz(i), Δ_i = Δ_{i-1} ^ L(ntz(i))
+// con L(j) = x^j · L, y cualquier tramo puede calcular su primer desplazamiento directamente.
+// Los bloques se reparten entre los hilos del pool y se cifran en lote con el motor del cifrador.
+//
+// Los bloques son big-endian (byte alto primero), igual que en el resto de modos.
+class PMAC {
+public:
+    static constexpr size_t TAG_SIZE = 2;
+    static constexpr uint16_t REDUCTION = 0x002D;
+    // Bloques por lote y mínimo de bloques por hilo al paralelizar
+    static constexpr size_t BATCH_BLOCKS = 1024;
+    static constexpr size_t PARALLEL_MIN_BLOCKS = 16384;
+
+private:
+    SimpleCipher cipher;
+    ThreadPool* pool = &ThreadPool::shared();
+    uint16_t offsets[64];       // L(j) = x^j · L
+    uint16_t lInverse;          // L · x⁻¹
+
+    static uint16_t doubleBlock(uint16_t value) {
+        return static_cast<uint16_t>((value << 1) ^ ((value & 0x8000) ? REDUCTION : 0));
+    }
+
+    static uint16_t halveBlock(uint16_t value) {
+        return static_cast<uint16_t>((value >> 1) ^ ((value & 1) ? (0x8000 | (REDUCTION >> 1)) : 0));
+    }
+
+    static int trailingZeros(uint64_t value) {
+        int count = 0;
+        while ((value & 1) == 0) {
+            value >>= 1;
+            count++;
+        }
+        return count;
+    }
+
+    void deriveOffsets() {
+        uint16_t l = cipher.encryptBlock(static_cast<uint16_t>(0));
+        lInverse = halveBlock(l);
+        for (int j = 0; j < 64; j++) {
+            offsets[j] = l;
+            l = doubleBlock(l);
+        }
+    }
+
+    // Δ_i = γ_i · L para el bloque i (contando desde 1)
+    uint16_t offsetAt(uint64_t index) const {
+        uint64_t gray = index ^ (index >> 1);
+        uint16_t offset = 0;
+        for (int j = 0; gray != 0; j++, gray >>= 1) {
+            if (gray & 1) {
+                offset ^= offsets[j];
+            }
+        }
+        return offset;
+    }
+
+public:
+    explicit PMAC(const SimpleCipher& blockCipher) : cipher(blockCipher) {
+        deriveOffsets();
+    }
+
+    // Cambiar el cifrador (clave y motor) del MAC
+    void setCipher(const SimpleCipher& blockCipher) {
+        cipher = blockCipher;
+        deriveOffsets();
+    }
+
+    // Usar otro pool de hilos (por defecto el compartido del proceso)
+    void setThreadPool(ThreadPool& threadPool) {
+        pool = &threadPool;
+    }
+
+    // Calcular el tag de length bytes
+    uint16_t computeTag(const uint8_t* data, size_t length) {
+        // Todos los bloques menos el último pasan por E; el último (completo, parcial o vacío) se trata aparte
+        size_t prefixBlocks = length == 0 ? 0 : (length - 1) / 2;
+        atomic<uint16_t> sigma{0};
+
+        cipher.prepare();
+        pool->parallelFor(prefixBlocks, PARALLEL_MIN_BLOCKS, [&](size_t begin, size_t end) {
+            uint16_t blocks[BATCH_BLOCKS];
+            uint16_t offset = offsetAt(begin + 1);
+            uint16_t partial = 0;
+            for (size_t start = begin; start < end; start += BATCH_BLOCKS) {
+                size_t count = min(BATCH_BLOCKS, end - start);
+                for (size_t i = 0; i < count; i++) {
+                    size_t index = start + i;
+                    if (index != begin) {
+                        offset ^= offsets[trailingZeros(index + 1)];
+                    }
+                    blocks[i] = static_cast<uint16_t>(((data[2 * index] << 8) | data[2 * index + 1]) ^ offset);
+                }
+                cipher.encryptBlocks(blocks, blocks, count);
+                for (size_t i = 0; i < count; i++) {
+                    partial ^= blocks[i];
+                }
+            }
+            sigma.fetch_xor(partial);
+        });
+
+        uint16_t sum = sigma.load();
+        size_t tail = length - 2 * prefixBlocks;
+        if (tail == 2) {
+            sum ^= static_cast<uint16_t>(((data[length - 2] << 8) | data[length - 1]) ^ lInverse);
+        } else if (tail == 1) {
+            sum ^= static_cast<uint16_t>((data[length - 1] << 8) | 0x80);
+        } else {
+            sum ^= 0x8000;
+        }
+        return cipher.encryptBlock(sum);
+    }
+
+    uint16_t computeTag(const string& data) {
+        return computeTag(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    }
+
+    // Comparar dos tags en tiempo constante (CRYPTO_memcmp no se detiene en el primer byte distinto)
+    static bool tagsEqual(uint16_t expected, uint16_t received) {
+        const uint8_t expectedBytes[TAG_SIZE] = {static_cast<uint8_t>(expected >> 8), static_cast<uint8_t>(expected)};
+        const uint8_t receivedBytes[TAG_SIZE] = {static_cast<uint8_t>(received >> 8), static_cast<uint8_t>(received)};
+        return CRYPTO_memcmp(expectedBytes, receivedBytes, TAG_SIZE) == 0;
+    }
+
+    bool verify(const uint8_t* data, size_t length, uint16_t tag) {
+        return tagsEqual(computeTag(data, length), tag);
+    }
+};
+
+#endif
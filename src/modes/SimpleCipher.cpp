@@ -5,61 +5,106 @@
 #include <string>
 #include <vector>
 #include <bitset>
+#include <memory>
+#include <array>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
 #include "../utils/CryptoUtils.h"
-#include "../SBox.h"
-#include "../Permutation.h"
+#include "../SPNetwork.h"
 #include "../KeySchedule.h"
+#include "../KeyCache.h"
 #include "../base/base64.h"
+#include "../engines/Codebook.h"
+#include "../engines/RoundTables.h"
+#include "../engines/Bitslice.h"
+#include "../engines/NibbleShuffle.h"
 
 using namespace std;
 
+// Motores disponibles para cifrar/descifrar bloques
+enum class CipherEngine {
+    REFERENCE,  // Red SP ronda por ronda (núcleo SPNetwork desenrollado)
+    CODEBOOK,   // Tabla completa de 64K entradas por clave (construida bajo demanda)
+    TTABLE,     // Tablas de ronda S-box + permutación compartidas (caben en L1)
+    BITSLICE,   // Lotes de 64/256/512 bloques en tiempo constante
+    SIMD        // S-box por PSHUFB y permutación por desplazamientos (SSSE3/AVX2/AVX-512)
+};
+
 class SimpleCipher {
+public:
+    // Núcleo de la red SP: 5 rondas con la S-box y la permutación por defecto
+    typedef DefaultSPNetwork Core;
+    static const int NUM_ROUNDS = Core::NUM_ROUNDS;
+
+    // El contexto de clave es el propio núcleo: clave maestra y llaves de ronda en línea.
+    // Las tablas (S-box, permutación, motores) son datos inmutables compartidos por el proceso.
+    static_assert(sizeof(Core) <= 16, "El contexto de clave debe caber en 16 bytes");
+
 private:
-    SBox sbox;
-    Permutation permutation;
-    KeySchedule* keySchedule;
-    static const int NUM_ROUNDS = 5;
+    Core core;
+    CipherEngine engine = CipherEngine::REFERENCE;
+    shared_ptr<const Codebook> codebook;
 
-public:
-    SimpleCipher() : sbox(4), keySchedule(nullptr) {
-        // Generar clave aleatoria por defecto
-        keySchedule = new KeySchedule(NUM_ROUNDS);
+    // Llaves de ronda permutadas con P^-1 para el descifrado del motor de tablas
+    array<uint16_t, NUM_ROUNDS> getDecryptRoundKeys() const {
+        const RoundTables& tables = RoundTables::shared();
+        array<uint16_t, NUM_ROUNDS> decryptKeys;
+        for (int round = 0; round < NUM_ROUNDS; round++) {
+            decryptKeys[round] = tables.inversePermute(core.getRoundKeys()[round]);
+        }
+        return decryptKeys;
+    }
+
+    // Obtener el codebook de la clave actual, construyéndolo la primera vez
+    const Codebook& getCodebook() {
+        if (!codebook) {
+            codebook = make_shared<const Codebook>([this](uint16_t block) {
+                return core.encrypt(block);
+            });
+        }
+        return *codebook;
     }
+
+public:
+    // Generar clave aleatoria por defecto
+    SimpleCipher() : core(KeySchedule::generateSecureRandomKey()) {}
     
     // Constructor con clave específica
-    SimpleCipher(uint16_t masterKey) : sbox(4), keySchedule(nullptr) {
-        keySchedule = new KeySchedule(masterKey, NUM_ROUNDS);
+    SimpleCipher(uint16_t masterKey) : core(masterKey) {}
+
+    // Cambiar de clave sin reservar memoria (el codebook de la clave anterior se descarta)
+    void setMasterKey(uint16_t masterKey) {
+        if (masterKey != core.getMasterKey()) {
+            core = Core(masterKey);
+            codebook.reset();
+        }
     }
-    
-    // Destructor
-    ~SimpleCipher() {
-        delete keySchedule;
+
+    uint16_t getMasterKey() const {
+        return core.getMasterKey();
     }
-    
-    // Copy constructor
-    SimpleCipher(const SimpleCipher& other) : sbox(4), keySchedule(nullptr) {
-        if (other.keySchedule) {
-            keySchedule = new KeySchedule(*other.keySchedule);
-        }
+
+    // Seleccionar el motor de cifrado de bloques
+    void setEngine(CipherEngine newEngine) {
+        engine = newEngine;
     }
-    
-    // Assignment operator
-    SimpleCipher& operator=(const SimpleCipher& other) {
-        if (this != &other) {
-            delete keySchedule;
-            keySchedule = nullptr;
-            if (other.keySchedule) {
-                keySchedule = new KeySchedule(*other.keySchedule);
-            }
+
+    CipherEngine getEngine() const {
+        return engine;
+    }
+
+    // Construir de antemano el estado perezoso del motor (codebook) para que
+    // encryptBlocks/decryptBlocks puedan llamarse desde varios hilos a la vez
+    void prepare() {
+        if (engine == CipherEngine::CODEBOOK) {
+            getCodebook();
         }
-        return *this;
     }
     
     // Obtener la clave maestra en formato Base64
     string getMasterKeyBase64() const {
-        if (!keySchedule) return "";
-        
-        uint16_t key = keySchedule->getMasterKey();
+        uint16_t key = core.getMasterKey();
         unsigned char keyBytes[2];
         keyBytes[0] = (key >> 8) & 0xFF;
         keyBytes[1] = key & 0xFF;
@@ -79,78 +124,182 @@ public:
         uint16_t key = (static_cast<uint16_t>(static_cast<unsigned char>(decodedData[0])) << 8) |
                        static_cast<uint16_t>(static_cast<unsigned char>(decodedData[1]));
         
-        delete keySchedule;
-        keySchedule = new KeySchedule(key, NUM_ROUNDS);
-    }    // Cifrar un bloque de 16 bits
-    bitset<16> encryptBlock(const bitset<16>& plaintext) {
-        bitset<16> state = plaintext;
-        
-        for (int round = 1; round <= NUM_ROUNDS; round++) {
-            uint16_t roundKey = keySchedule->getRoundKey(round);
-            bitset<16> keyBits(roundKey);
-            state ^= keyBits;
-            
-            vector<unsigned int> nibbles;
-            for (int i = 0; i < 4; i++) {
-                bitset<4> nibble = CryptoUtils::separateBitsReverse(state, i * 4);
-                unsigned int nibbleValue = static_cast<unsigned int>(nibble.to_ulong());
-                unsigned int sboxResult = sbox.applySBox(nibbleValue);
-                nibbles.push_back(sboxResult);
-            }
-            
-            state = CryptoUtils::construirBitset(nibbles);
-            state = permutation.applyPermutation(state);
+        setMasterKey(key);
+    }
+
+    // Configurar la clave a través del caché: una clave caliente no se decodifica ni se expande
+    void setMasterKeyFromBase64(const string& base64Key, KeyCache& keyCache) {
+        shared_ptr<const KeyCache::Entry> entry = keyCache.get(base64Key);
+        core = entry->core;
+        codebook = entry->codebook;
+    }
+
+    // Cifrar un bloque de 16 bits (sin reservas de memoria)
+    uint16_t encryptBlock(uint16_t plaintext) {
+        switch (engine) {
+            case CipherEngine::CODEBOOK:
+                return getCodebook().encrypt(plaintext);
+            case CipherEngine::TTABLE:
+                return RoundTables::shared().encrypt(plaintext, core.getRoundKeys().data(), NUM_ROUNDS);
+            case CipherEngine::BITSLICE:
+            case CipherEngine::SIMD:
+                encryptBlocks(&plaintext, &plaintext, 1);
+                return plaintext;
+            default:
+                return core.encrypt(plaintext);
         }
-        
-        return state;
     }
 
-    // Descifrar un bloque de 16 bits
+    // Descifrar un bloque de 16 bits (sin reservas de memoria)
+    uint16_t decryptBlock(uint16_t ciphertext) {
+        switch (engine) {
+            case CipherEngine::CODEBOOK:
+                return getCodebook().decrypt(ciphertext);
+            case CipherEngine::TTABLE:
+            case CipherEngine::BITSLICE:
+            case CipherEngine::SIMD:
+                decryptBlocks(&ciphertext, &ciphertext, 1);
+                return ciphertext;
+            default:
+                return core.decrypt(ciphertext);
+        }
+    }
+
+    // Adaptadores bitset del bloque de 16 bits
+    bitset<16> encryptBlock(const bitset<16>& plaintext) {
+        return bitset<16>(encryptBlock(static_cast<uint16_t>(plaintext.to_ulong())));
+    }
+
     bitset<16> decryptBlock(const bitset<16>& ciphertext) {
-        bitset<16> state = ciphertext;
-        
-        for (int round = NUM_ROUNDS; round >= 1; round--) {
-            state = permutation.applyInversePermutation(state);
-            
-            vector<unsigned int> nibbles;
-            for (int i = 0; i < 4; i++) {
-                bitset<4> nibble = CryptoUtils::separateBitsReverse(state, i * 4);
-                unsigned int nibbleValue = static_cast<unsigned int>(nibble.to_ulong());
-                unsigned int inverseSboxResult = sbox.applyInverseSBox(nibbleValue);
-                nibbles.push_back(inverseSboxResult);
+        return bitset<16>(decryptBlock(static_cast<uint16_t>(ciphertext.to_ulong())));
+    }
+
+    // Cifrar count bloques de una vez (input y output pueden coincidir)
+    void encryptBlocks(const uint16_t* input, uint16_t* output, size_t count) {
+        if (engine == CipherEngine::BITSLICE) {
+            Bitslice::encryptBlocks(input, output, count, core.getRoundKeys().data(), NUM_ROUNDS);
+            return;
+        }
+        if (engine == CipherEngine::SIMD) {
+            NibbleShuffle::encryptBlocks(input, output, count, core.getRoundKeys().data(), NUM_ROUNDS);
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            output[i] = encryptBlock(input[i]);
+        }
+    }
+
+    // Descifrar count bloques de una vez (input y output pueden coincidir)
+    void decryptBlocks(const uint16_t* input, uint16_t* output, size_t count) {
+        if (engine == CipherEngine::BITSLICE) {
+            Bitslice::decryptBlocks(input, output, count, core.getRoundKeys().data(), NUM_ROUNDS);
+            return;
+        }
+        if (engine == CipherEngine::SIMD) {
+            NibbleShuffle::decryptBlocks(input, output, count, core.getRoundKeys().data(), NUM_ROUNDS);
+            return;
+        }
+        if (engine == CipherEngine::TTABLE) {
+            const RoundTables& tables = RoundTables::shared();
+            array<uint16_t, NUM_ROUNDS> decryptKeys = getDecryptRoundKeys();
+            for (size_t i = 0; i < count; i++) {
+                output[i] = tables.decrypt(input[i], core.getRoundKeys().data(), decryptKeys.data(), NUM_ROUNDS);
             }
-            
-            state = CryptoUtils::construirBitset(nibbles);
-            
-            uint16_t roundKey = keySchedule->getRoundKey(round);
-            bitset<16> keyBits(roundKey);
-            state ^= keyBits;
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            output[i] = decryptBlock(input[i]);
         }
-        
-        return state;
     }
 
     // Cifrar mensaje completo (modo ECB básico)
-    vector<bitset<16>> encryptMessage(const vector<bitset<16>>& message) {
-        vector<bitset<16>> ciphertext;
-        ciphertext.reserve(message.size());
-        
-        for (const auto& block : message) {
-            ciphertext.push_back(encryptBlock(block));
-        }
-        
+    vector<uint16_t> encryptMessage(const vector<uint16_t>& message) {
+        vector<uint16_t> ciphertext(message.size());
+        encryptBlocks(message.data(), ciphertext.data(), message.size());
         return ciphertext;
     }
 
+    vector<bitset<16>> encryptMessage(const vector<bitset<16>>& message) {
+        return CryptoUtils::toBitsets(encryptMessage(CryptoUtils::toBlocks16(message)));
+    }
+
     // Descifrar mensaje completo (modo ECB básico)
+    vector<uint16_t> decryptMessage(const vector<uint16_t>& ciphertext) {
+        vector<uint16_t> plaintext(ciphertext.size());
+        decryptBlocks(ciphertext.data(), plaintext.data(), ciphertext.size());
+        return plaintext;
+    }
+
     vector<bitset<16>> decryptMessage(const vector<bitset<16>>& ciphertext) {
-        vector<bitset<16>> plaintext;
-        plaintext.reserve(ciphertext.size());
-        
-        for (const auto& block : ciphertext) {
-            plaintext.push_back(decryptBlock(block));
+        return CryptoUtils::toBitsets(decryptMessage(CryptoUtils::toBlocks16(ciphertext)));
+    }
+
+    // ========== BYTES (BINARIO, RELLENO PKCS#7) ==========
+
+    // Cifrar length bytes con relleno PKCS#7; output necesita CryptoUtils::pkcs7PaddedSize(length)
+    // bytes y puede coincidir con input. Devuelve la longitud del texto cifrado.
+    size_t encryptBytes(const uint8_t* input, size_t length, uint8_t* output) {
+        size_t fullBlocks = length / CryptoUtils::BLOCK_BYTES;
+        // El último bloque se arma antes de sobrescribir la entrada
+        uint16_t finalBlock = CryptoUtils::pkcs7FinalBlock(input + fullBlocks * CryptoUtils::BLOCK_BYTES,
+                                                           length % CryptoUtils::BLOCK_BYTES);
+        CryptoUtils::transformBytes(input, output, fullBlocks, [this](uint16_t* blocks, size_t count) {
+            encryptBlocks(blocks, blocks, count);
+        });
+        CryptoUtils::storeBlock(output + fullBlocks * CryptoUtils::BLOCK_BYTES, encryptBlock(finalBlock));
+        return CryptoUtils::pkcs7PaddedSize(length);
+    }
+
+    // Descifrar length bytes y quitar el relleno; output necesita length bytes y puede
+    // coincidir con input. Devuelve la longitud del texto plano.
+    size_t decryptBytes(const uint8_t* input, size_t length, uint8_t* output) {
+        if (length == 0 || length % CryptoUtils::BLOCK_BYTES != 0) {
+            throw invalid_argument("Texto cifrado invalido: longitud no es multiplo del bloque");
         }
-          return plaintext;
+        CryptoUtils::transformBytes(input, output, length / CryptoUtils::BLOCK_BYTES, [this](uint16_t* blocks, size_t count) {
+            decryptBlocks(blocks, blocks, count);
+        });
+        return CryptoUtils::pkcs7UnpaddedSize(output, length);
+    }
+
+#if __cplusplus >= 202002L
+    // Cifrar en el lugar: data debe tener capacidad para el relleno; devuelve el tramo cifrado
+    span<uint8_t> encryptBytes(span<uint8_t> data, size_t length) {
+        if (data.size() < CryptoUtils::pkcs7PaddedSize(length)) {
+            throw invalid_argument("Buffer insuficiente para el relleno PKCS#7");
+        }
+        return data.first(encryptBytes(data.data(), length, data.data()));
+    }
+
+    // Descifrar en el lugar; devuelve el tramo de texto plano sin relleno
+    span<uint8_t> decryptBytes(span<uint8_t> data) {
+        return data.first(decryptBytes(data.data(), data.size(), data.data()));
+    }
+#endif
+
+    // ========== TUBERÍAS FUSIONADAS CON BASE64 ==========
+    // Equivalen a blocksToBase64(encryptMessage(stringToBlocks16(texto))) y a
+    // blocksToString(decryptMessage(base64ToBlocks16(base64))) pero en una sola pasada por
+    // mosaicos que caben en L1: lectura, cifrado y codificación sin cadenas ni vectores intermedios.
+
+    string encryptToBase64(const string& plaintext) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(plaintext.data());
+        size_t length = plaintext.size();
+        return CryptoUtils::blockTilesToBase64(nullptr, 0, (length + 1) / 2,
+            [this, bytes, length](uint16_t* blocks, size_t start, size_t count) {
+                CryptoUtils::loadBlocks(bytes, length, start, blocks, count);
+                encryptBlocks(blocks, blocks, count);
+            });
+    }
+
+    string decryptFromBase64(const string& base64Data) {
+        string plaintext;
+        plaintext.reserve(base64Data.length() / 4 * 3);
+        CryptoUtils::base64ToBlockTiles(base64Data, nullptr, 0, [this, &plaintext](uint16_t* blocks, size_t count) {
+            decryptBlocks(blocks, blocks, count);
+            CryptoUtils::appendText(plaintext, blocks, count);
+        });
+        return plaintext;
     }
 };
 
@@ -0,0 +1,229 @@
+#ifndef STREAMINGCIPHER_H
+#define STREAMINGCIPHER_H
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <openssl/rand.h>
+#include "SimpleCipher.cpp"
+#include "WideCTRCipher.cpp"
+#include "../utils/CryptoUtils.h"
+#include "../engines/BlockXor.h"
+
+using namespace std;
+
+// Modos soportados por los contextos incrementales
+enum class StreamMode {
+    ECB,
+    CBC,
+    CTR
+};
+
+// ========== CONTEXTO INCREMENTAL (INIT / UPDATE / FINAL) ==========
+// Procesa un mensaje en trozos de bytes de cualquier longitud sin tenerlo completo en memoria.
+// Entre llamadas se conserva el estado del modo (bloque anterior en CBC, desplazamiento en CTR)
+// y el byte suelto de un bloque incompleto. Los bloques completos se procesan en lotes con el
+// motor del cifrador y se escriben en el búfer del llamador.
+//
+// ECB/CBC usan bloques big-endian y relleno PKCS#7 como encryptBytes y FileCipher: final
+// siempre agrega un bloque de relleno al cifrar. Al descifrar, el último bloque descifrado se
+// retiene entre llamadas hasta final, que comprueba y quita el relleno.
+// CTR usa el keystream de WideCTRCipher (nonce de 32 bits y desplazamiento en bytes de 64 bits),
+// no el contador de 8 bits de CTRCipher, así que un flujo no se limita a 256 bloques.
+class StreamingCipher {
+public:
+    static constexpr size_t BATCH_BLOCKS = 1024;
+
+private:
+    SimpleCipher cipher;
+    WideCTRCipher ctr;          // CTR: generador del keystream con la misma clave
+    StreamMode mode;
+    bool encrypting;
+    uint32_t iv;                // IV de 16 bits en CBC, nonce de 32 bits en CTR
+    uint16_t previousBlock;     // CBC: último bloque cifrado (o IV)
+    uint64_t offset = 0;        // CTR: bytes ya procesados
+    uint8_t pendingByte = 0;
+    bool hasPending = false;
+    uint16_t heldBlock = 0;     // ECB/CBC al descifrar: último bloque, puede llevar el relleno
+    bool hasHeld = false;
+    bool finished = false;
+
+    StreamingCipher(const SimpleCipher& blockCipher, StreamMode streamMode, bool encrypt, uint32_t initialIV)
+        : cipher(blockCipher), mode(streamMode), encrypting(encrypt), iv(initialIV),
+          previousBlock(static_cast<uint16_t>(initialIV)) {
+        if (mode == StreamMode::CBC && initialIV > UINT16_MAX) {
+            throw invalid_argument("IV CBC invalido: debe caber en 16 bits");
+        }
+        if (mode == StreamMode::CTR) {
+            ctr.setMasterKeyFromBase64(cipher.getMasterKeyBase64());
+            ctr.setEngine(cipher.getEngine());
+        }
+    }
+
+    static uint16_t generateRandomIV() {
+        unsigned char randomBytes[2];
+        if (RAND_bytes(randomBytes, 2) != 1) {
+            throw runtime_error("Error: No se pudo generar IV con OpenSSL");
+        }
+        return (static_cast<uint16_t>(randomBytes[0]) << 8) | static_cast<uint16_t>(randomBytes[1]);
+    }
+
+    // Aplicar ECB/CBC a count bloques consecutivos del flujo (en el lugar)
+    void processBlocks(uint16_t* blocks, size_t count) {
+        if (mode == StreamMode::ECB) {
+            if (encrypting) {
+                cipher.encryptBlocks(blocks, blocks, count);
+            } else {
+                cipher.decryptBlocks(blocks, blocks, count);
+            }
+        } else if (encrypting) {
+            for (size_t i = 0; i < count; i++) {
+                blocks[i] = cipher.encryptBlock(static_cast<uint16_t>(blocks[i] ^ previousBlock));
+                previousBlock = blocks[i];
+            }
+        } else {
+            uint16_t ciphertext[BATCH_BLOCKS];
+            copy(blocks, blocks + count, ciphertext);
+            cipher.decryptBlocks(blocks, blocks, count);
+            blocks[0] ^= previousBlock;
+            BlockXor::apply(blocks + 1, ciphertext, blocks + 1, count - 1);
+            previousBlock = ciphertext[count - 1];
+        }
+    }
+
+    // Escribir un bloque procesado; al descifrar se escribe el retenido y se retiene el nuevo
+    void emitBlock(uint16_t block, uint8_t* output, size_t& written) {
+        if (!encrypting) {
+            swap(block, heldBlock);
+            if (!hasHeld) {
+                hasHeld = true;
+                return;
+            }
+        }
+        CryptoUtils::storeBlock(output + written, block);
+        written += 2;
+    }
+
+    void ensureActive() const {
+        if (finished) {
+            throw runtime_error("El contexto de flujo ya fue finalizado");
+        }
+    }
+
+public:
+    // Contexto de cifrado con IV aleatorio (16 bits en CBC, nonce de 32 bits en CTR; ECB no lo usa)
+    static StreamingCipher encryptor(const SimpleCipher& blockCipher, StreamMode mode) {
+        uint32_t iv = 0;
+        if (mode == StreamMode::CBC) {
+            iv = generateRandomIV();
+        } else if (mode == StreamMode::CTR) {
+            iv = WideCTRCipher::generateNonce();
+        }
+        return StreamingCipher(blockCipher, mode, true, iv);
+    }
+
+    // Contexto de cifrado con un IV dado
+    static StreamingCipher encryptor(const SimpleCipher& blockCipher, StreamMode mode, uint32_t iv) {
+        return StreamingCipher(blockCipher, mode, true, iv);
+    }
+
+    // Contexto de descifrado con el IV del mensaje
+    static StreamingCipher decryptor(const SimpleCipher& blockCipher, StreamMode mode, uint32_t iv = 0) {
+        return StreamingCipher(blockCipher, mode, false, iv);
+    }
+
+    uint32_t getIV() const {
+        return iv;
+    }
+
+    // Tamaño de búfer suficiente para la salida de update con length bytes de entrada
+    static size_t maxOutputSize(size_t length) {
+        return length + 1;
+    }
+
+    // Procesar un trozo; escribe en output los bytes de los bloques completados y devuelve cuántos
+    size_t update(const uint8_t* input, size_t length, uint8_t* output) {
+        ensureActive();
+        if (mode == StreamMode::CTR) {
+            // CTR no necesita bloques completos: el keystream se aplica byte a byte desde offset
+            ctr.applyKeystreamBytes(iv, offset, input, output, length);
+            offset += length;
+            return length;
+        }
+        size_t written = 0;
+
+        // Completar el bloque que quedó a medias en la llamada anterior
+        if (hasPending && length > 0) {
+            uint16_t block = static_cast<uint16_t>((pendingByte << 8) | input[0]);
+            processBlocks(&block, 1);
+            emitBlock(block, output, written);
+            hasPending = false;
+            input++;
+            length--;
+        }
+
+        uint16_t blocks[BATCH_BLOCKS];
+        while (length >= 2) {
+            size_t count = min(BATCH_BLOCKS, length / 2);
+            for (size_t i = 0; i < count; i++) {
+                blocks[i] = static_cast<uint16_t>((input[2 * i] << 8) | input[2 * i + 1]);
+            }
+            processBlocks(blocks, count);
+            for (size_t i = 0; i < count; i++) {
+                emitBlock(blocks[i], output, written);
+            }
+            input += 2 * count;
+            length -= 2 * count;
+        }
+
+        if (length == 1) {
+            pendingByte = input[0];
+            hasPending = true;
+        }
+        return written;
+    }
+
+    // Terminar el flujo (hasta 2 bytes de salida) y cerrar el contexto. ECB/CBC: al cifrar
+    // emite el bloque de relleno PKCS#7; al descifrar quita el relleno del bloque retenido.
+    size_t final(uint8_t* output) {
+        ensureActive();
+        finished = true;
+        if (mode == StreamMode::CTR) {
+            return 0;
+        }
+
+        if (encrypting) {
+            uint16_t block = CryptoUtils::pkcs7FinalBlock(&pendingByte, hasPending ? 1 : 0);
+            hasPending = false;
+            processBlocks(&block, 1);
+            CryptoUtils::storeBlock(output, block);
+            return 2;
+        }
+        if (hasPending) {
+            throw invalid_argument("Texto cifrado incompleto: falta un byte del ultimo bloque");
+        }
+        uint8_t last[2];
+        CryptoUtils::storeBlock(last, heldBlock);
+        size_t size = CryptoUtils::pkcs7UnpaddedSize(last, hasHeld ? 2 : 0);
+        hasHeld = false;
+        copy(last, last + size, output);
+        return size;
+    }
+
+    // Variantes con string para trozos de texto o datos binarios
+    string update(const string& input) {
+        string output(maxOutputSize(input.size()), '\0');
+        size_t written = update(reinterpret_cast<const uint8_t*>(input.data()), input.size(),
+                                reinterpret_cast<uint8_t*>(&output[0]));
+        output.resize(written);
+        return output;
+    }
+
+    string final() {
+        uint8_t output[2];
+        size_t written = final(output);
+        return string(reinterpret_cast<char*>(output), written);
+    }
+};
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef WIDECTRCIPHER_H
+#define WIDECTRCIPHER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <stdexcept>
+#include <openssl/rand.h>
+#include "SimpleCipher.cpp"
+#include "../utils/ThreadPool.h"
+
+using namespace std;
+
+// ========== MODO CTR DE CONTADOR ANCHO ==========
+// El bloque contador del CTR clásico (IV de 8 bits || contador de 8 bits) se repite cada
+// 256 bloques. Aquí la posición del bloque es un índice de 64 bits dividido en segmentos
+// de 2^16 bloques: cada segmento usa una clave y un tweak de 16 bits derivados por separado de
+// (clave maestra, nonce de 32 bits, índice de segmento), y dentro del segmento el bloque
+// contador es (índice & 0xFFFF) ^ tweak, que no se repite en los 2^16 bloques.
+// El keystream de cualquier bloque depende solo de su posición, de modo que cada hilo
+// puede procesar segmentos independientes de una entrada enorme.
+//
+// Formato: "WC" | versión (1 byte) | bits por segmento (1 byte) | nonce (4 bytes, big-endian)
+// seguido del texto cifrado con la misma longitud en bytes que el texto plano.
+// El bloque i cubre los bytes 2i (byte alto) y 2i + 1 (byte bajo).
+class WideCTRCipher {
+public:
+    static constexpr int SEGMENT_BITS = 16;
+    static constexpr uint64_t SEGMENT_BLOCKS = uint64_t(1) << SEGMENT_BITS;
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 8;
+    // Bloques por lote de keystream y mínimo de bloques por hilo al paralelizar
+    static constexpr size_t KEYSTREAM_BATCH = 1024;
+    static constexpr size_t PARALLEL_MIN_BLOCKS = 16384;
+    // Etiquetas de dominio de las cadenas de derivación ("KY" y "TW")
+    static constexpr uint16_t KEY_LABEL = 0x4B59;
+    static constexpr uint16_t TWEAK_LABEL = 0x5457;
+
+private:
+    SimpleCipher cipher;
+    ThreadPool* pool = &ThreadPool::shared();
+
+    // Cifrador y tweak de un segmento
+    struct SegmentContext {
+        SimpleCipher cipher;
+        uint16_t tweak;
+    };
+
+    // Encadenar la clave maestra (estilo CBC-MAC) sobre count palabras de 16 bits
+    uint16_t chainWords(const uint16_t* words, size_t count) {
+        uint16_t state = 0;
+        for (size_t i = 0; i < count; i++) {
+            state = cipher.encryptBlock(static_cast<uint16_t>(state ^ words[i]));
+        }
+        return state;
+    }
+
+    // Derivar clave y tweak del segmento con dos cadenas separadas por etiqueta. La cadena del
+    // tweak termina en los bits 16-31 del índice y la de la clave en los bits 0-15; como el último
+    // paso de cada cadena es una permutación de su última palabra, el par (clave, tweak) es
+    // distinto en los 2^32 segmentos (2^48 bloques) de cada nonce. Con una sola cadena sobre el
+    // índice completo el par se repetía a partir del segmento 2^16.
+    SegmentContext deriveSegment(uint32_t nonce, uint64_t segment) {
+        const uint16_t keyWords[6] = {
+            KEY_LABEL,
+            static_cast<uint16_t>(nonce >> 16), static_cast<uint16_t>(nonce),
+            static_cast<uint16_t>(segment >> 32), static_cast<uint16_t>(segment >> 16),
+            static_cast<uint16_t>(segment)
+        };
+        const uint16_t tweakWords[5] = {
+            TWEAK_LABEL,
+            static_cast<uint16_t>(nonce >> 16), static_cast<uint16_t>(nonce),
+            static_cast<uint16_t>(segment >> 32), static_cast<uint16_t>(segment >> 16)
+        };
+        uint16_t segmentKey = chainWords(keyWords, 6);
+        uint16_t tweak = chainWords(tweakWords, 5);
+
+        // El codebook se construiría para cada segmento: se usan las tablas de ronda en su lugar
+        SegmentContext context{SimpleCipher(segmentKey), tweak};
+        CipherEngine engine = cipher.getEngine();
+        context.cipher.setEngine(engine == CipherEngine::CODEBOOK ? CipherEngine::TTABLE : engine);
+        return context;
+    }
+
+    // Recorrer el keystream de los bloques [firstBlock, firstBlock + count) en lotes:
+    // consume(índice del primer bloque del lote, keystream, tamaño del lote)
+    template <typename Consumer>
+    void forEachKeystreamBatch(uint32_t nonce, uint64_t firstBlock, size_t count, const Consumer& consume) {
+        uint16_t keystream[KEYSTREAM_BATCH];
+        uint64_t block = firstBlock;
+        uint64_t endBlock = firstBlock + count;
+        while (block < endBlock) {
+            uint64_t segment = block >> SEGMENT_BITS;
+            SegmentContext context = deriveSegment(nonce, segment);
+            uint64_t segmentEnd = min(endBlock, (segment + 1) << SEGMENT_BITS);
+
+            while (block < segmentEnd) {
+                size_t batch = static_cast<size_t>(min<uint64_t>(KEYSTREAM_BATCH, segmentEnd - block));
+                for (size_t i = 0; i < batch; i++) {
+                    keystream[i] = static_cast<uint16_t>(((block + i) & 0xFFFF) ^ context.tweak);
+                }
+                context.cipher.encryptBlocks(keystream, keystream, batch);
+                consume(block, keystream, batch);
+                block += batch;
+            }
+        }
+    }
+
+public:
+    WideCTRCipher() {}
+
+    // Generar nonce aleatorio de 32 bits
+    static uint32_t generateNonce() {
+        unsigned char randomBytes[4];
+
+        if (RAND_bytes(randomBytes, 4) != 1) {
+            // Si falla, usar fallback con random_device
+            random_device rd;
+            return static_cast<uint32_t>(rd());
+        }
+
+        return (static_cast<uint32_t>(randomBytes[0]) << 24) |
+               (static_cast<uint32_t>(randomBytes[1]) << 16) |
+               (static_cast<uint32_t>(randomBytes[2]) << 8) |
+               static_cast<uint32_t>(randomBytes[3]);
+    }
+
+    // Obtener la clave maestra en formato Base64
+    string getMasterKeyBase64() const {
+        return cipher.getMasterKeyBase64();
+    }
+
+    // Configurar nueva clave desde Base64
+    void setMasterKeyFromBase64(const string& base64Key) {
+        cipher.setMasterKeyFromBase64(base64Key);
+    }
+
+    void setMasterKeyFromBase64(const string& base64Key, KeyCache& keyCache) {
+        cipher.setMasterKeyFromBase64(base64Key, keyCache);
+    }
+
+    // Seleccionar el motor de cifrado de bloques
+    void setEngine(CipherEngine engine) {
+        cipher.setEngine(engine);
+    }
+
+    // Usar otro pool de hilos (por defecto el compartido del proceso)
+    void setThreadPool(ThreadPool& threadPool) {
+        pool = &threadPool;
+    }
+
+    // ========== ENCABEZADO ==========
+
+    static string encodeHeader(uint32_t nonce) {
+        string header;
+        header += 'W';
+        header += 'C';
+        header += static_cast<char>(FORMAT_VERSION);
+        header += static_cast<char>(SEGMENT_BITS);
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            header += static_cast<char>((nonce >> shift) & 0xFF);
+        }
+        return header;
+    }
+
+    // Validar el encabezado y devolver el nonce
+    static uint32_t decodeHeader(const uint8_t* data, size_t length) {
+        if (length < HEADER_SIZE || data[0] != 'W' || data[1] != 'C') {
+            throw invalid_argument("Datos CTR ancho invalidos: encabezado ausente");
+        }
+        if (data[2] != FORMAT_VERSION || data[3] != SEGMENT_BITS) {
+            throw invalid_argument("Datos CTR ancho invalidos: version no soportada");
+        }
+        return (static_cast<uint32_t>(data[4]) << 24) | (static_cast<uint32_t>(data[5]) << 16) |
+               (static_cast<uint32_t>(data[6]) << 8) | static_cast<uint32_t>(data[7]);
+    }
+
+    // ========== KEYSTREAM POSICIONAL ==========
+
+    // Cifrar/descifrar count bloques desde el bloque startBlock (input y output pueden coincidir).
+    // Las entradas grandes se reparten en tramos contiguos entre los hilos del pool.
+    void applyKeystream(uint32_t nonce, uint64_t startBlock, const uint16_t* input, uint16_t* output, size_t count) {
+        cipher.prepare();
+        pool->parallelFor(count, PARALLEL_MIN_BLOCKS, [&](size_t begin, size_t end) {
+            forEachKeystreamBatch(nonce, startBlock + begin, end - begin,
+                [&](uint64_t block, const uint16_t* keystream, size_t batch) {
+                    size_t position = static_cast<size_t>(block - startBlock);
+                    for (size_t i = 0; i < batch; i++) {
+                        output[position + i] = static_cast<uint16_t>(input[position + i] ^ keystream[i]);
+                    }
+                });
+        });
+    }
+
+    // Cifrar/descifrar length bytes que empiezan en el byte byteOffset del flujo
+    // (input y output pueden coincidir; el desplazamiento puede ser impar)
+    void applyKeystreamBytes(uint32_t nonce, uint64_t byteOffset, const uint8_t* input, uint8_t* output, size_t length) {
+        if (length == 0) {
+            return;
+        }
+        uint64_t firstBlock = byteOffset / 2;
+        uint64_t endByte = byteOffset + length;
+        size_t blockCount = static_cast<size_t>((endByte + 1) / 2 - firstBlock);
+
+        cipher.prepare();
+        pool->parallelFor(blockCount, PARALLEL_MIN_BLOCKS, [&](size_t begin, size_t end) {
+            forEachKeystreamBatch(nonce, firstBlock + begin, end - begin,
+                [&](uint64_t block, const uint16_t* keystream, size_t batch) {
+                    for (size_t i = 0; i < batch; i++) {
+                        uint64_t highByte = 2 * (block + i);
+                        if (highByte >= byteOffset && highByte < endByte) {
+                            size_t position = static_cast<size_t>(highByte - byteOffset);
+                            output[position] = static_cast<uint8_t>(input[position] ^ (keystream[i] >> 8));
+                        }
+                        if (highByte + 1 >= byteOffset && highByte + 1 < endByte) {
+                            size_t position = static_cast<size_t>(highByte + 1 - byteOffset);
+                            output[position] = static_cast<uint8_t>(input[position] ^ (keystream[i] & 0xFF));
+                        }
+                    }
+                });
+        });
+    }
+
+    // ========== MENSAJES COMPLETOS ==========
+
+    // Cifrar: encabezado con nonce aleatorio seguido del texto cifrado
+    string encrypt(const string& plaintext) {
+        uint32_t nonce = generateNonce();
+        string result = encodeHeader(nonce);
+        result.resize(HEADER_SIZE + plaintext.size());
+        applyKeystreamBytes(nonce, 0, reinterpret_cast<const uint8_t*>(plaintext.data()),
+                            reinterpret_cast<uint8_t*>(&result[HEADER_SIZE]), plaintext.size());
+        return result;
+    }
+
+    // Descifrar un mensaje con encabezado
+    string decrypt(const string& data) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data.data());
+        uint32_t nonce = decodeHeader(bytes, data.size());
+        string plaintext(data.size() - HEADER_SIZE, '\0');
+        applyKeystreamBytes(nonce, 0, bytes + HEADER_SIZE, reinterpret_cast<uint8_t*>(&plaintext[0]), plaintext.size());
+        return plaintext;
+    }
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+using namespace std;
+
+// Las rutas vectoriales se compilan con atributos target de GCC/Clang y se eligen en tiempo de ejecución
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TOYCIPHER_X86_DISPATCH 1
+#endif
+
+// Núcleos genéricos que deben expandirse dentro de funciones con atributo target
+#if defined(__GNUC__) || defined(__clang__)
+#define TOYCIPHER_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define TOYCIPHER_ALWAYS_INLINE inline
+#endif
+
+// ========== CLASE PARA DETECCIÓN DE CARACTERÍSTICAS DEL CPU ==========
+class CpuFeatures {
+public:
+    static bool hasSSE2() {
+#ifdef TOYCIPHER_X86_DISPATCH
+        static const bool supported = __builtin_cpu_supports("sse2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    static bool hasSSSE3() {
+#ifdef TOYCIPHER_X86_DISPATCH
+        static const bool supported = __builtin_cpu_supports("ssse3");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    static bool hasAVX2() {
+#ifdef TOYCIPHER_X86_DISPATCH
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    static bool hasBMI2() {
+#ifdef TOYCIPHER_X86_DISPATCH
+        static const bool supported = __builtin_cpu_supports("bmi2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    static bool hasAVX512() {
+#ifdef TOYCIPHER_X86_DISPATCH
+        static const bool supported = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        return supported;
+#else
+        return false;
+#endif
+    }
+};
+
+#endif
@@ -8,7 +8,10 @@
 #include <sstream>
 #include <bitset>
 #include <cstdint>
+#include <algorithm>
+#include <stdexcept>
 #include "../base/base64.cpp"
+#include "../base/base64Stream.h"
 
 using namespace std;
 
@@ -65,91 +68,288 @@ public:
         return bits;
     }
 
+    // Bloques distintos del contador CTR de 8 bits antes de que el keystream se repita
+    static constexpr size_t CTR_COUNTER_BLOCKS = 256;
+
+    // Rechazar los bloques [startBlock, startBlock + count) si pasan del bloque 256 del mensaje:
+    // el CTR clásico no repite el keystream en silencio (WideCTRCipher no tiene este límite)
+    static void checkCounterRange(uint64_t startBlock, size_t count) {
+        if (startBlock > CTR_COUNTER_BLOCKS || count > CTR_COUNTER_BLOCKS - startBlock) {
+            throw invalid_argument("Mensaje CTR demasiado largo: el contador de 8 bits se repite tras 256 bloques");
+        }
+    }
+
+    // Combine IV with counter to generate a new 16-bit value
+    static uint16_t counterGenerator(uint8_t iv, unsigned int counter) {
+        return static_cast<uint16_t>((iv << 8) | (counter & 0xFF));
+    }
+
     static bitset<16> counterGenerator(const bitset<8>& iv, unsigned int counter) {
-        // Combine IV with counter to generate a new 16-bit value
-        unsigned int combined = (iv.to_ulong() << 8) | (counter & 0xFF);
-        bitset<16> result;
-        for (int i = 0; i < 16; ++i) {
-            result[i] = (combined >> i) & 1;
+        return bitset<16>(counterGenerator(static_cast<uint8_t>(iv.to_ulong()), counter));
+    }
+
+    // ========== ADAPTADORES BITSET <-> UINT16 ==========
+
+    static vector<uint16_t> toBlocks16(const vector<bitset<16>>& blocks) {
+        vector<uint16_t> result(blocks.size());
+        for (size_t i = 0; i < blocks.size(); i++) {
+            result[i] = static_cast<uint16_t>(blocks[i].to_ulong());
         }
         return result;
     }
 
+    static vector<bitset<16>> toBitsets(const vector<uint16_t>& blocks) {
+        vector<bitset<16>> result;
+        result.reserve(blocks.size());
+        for (uint16_t block : blocks) {
+            result.push_back(bitset<16>(block));
+        }
+        return result;
+    }
+
+    // Leer un bloque big-endian de dos bytes (el segundo puede faltar al final de los datos)
+    static uint16_t readBlock(const string& data, size_t pos) {
+        uint16_t blockValue = static_cast<uint16_t>(static_cast<unsigned char>(data[pos]) << 8);
+        if (pos + 1 < data.length()) {
+            blockValue |= static_cast<unsigned char>(data[pos + 1]);
+        }
+        return blockValue;
+    }
+
+    // Agregar un bloque big-endian de dos bytes
+    static void appendBlock(string& data, uint16_t block) {
+        data += static_cast<char>((block >> 8) & 0xFF);
+        data += static_cast<char>(block & 0xFF);
+    }
+
+    // ========== BYTES Y RELLENO PKCS#7 ==========
+
+    static constexpr size_t BLOCK_BYTES = 2;
+    static constexpr size_t BYTE_BATCH_BLOCKS = 1024;
+
+    // Tamaño con relleno PKCS#7: siempre se agrega entre 1 y 2 bytes
+    static size_t pkcs7PaddedSize(size_t length) {
+        return (length / BLOCK_BYTES + 1) * BLOCK_BYTES;
+    }
+
+    // Último bloque con relleno PKCS#7 a partir de los bytes sobrantes (0 o 1) del mensaje
+    static uint16_t pkcs7FinalBlock(const uint8_t* tail, size_t tailLength) {
+        if (tailLength == 1) {
+            return static_cast<uint16_t>((tail[0] << 8) | 0x01);
+        }
+        return 0x0202;
+    }
+
+    // Longitud sin relleno PKCS#7 de datos ya descifrados
+    static size_t pkcs7UnpaddedSize(const uint8_t* data, size_t length) {
+        if (length == 0 || length % BLOCK_BYTES != 0) {
+            throw invalid_argument("Relleno PKCS#7 invalido: longitud no es multiplo del bloque");
+        }
+        uint8_t padding = data[length - 1];
+        if (padding < 1 || padding > BLOCK_BYTES) {
+            throw invalid_argument("Relleno PKCS#7 invalido");
+        }
+        for (size_t i = length - padding; i < length; i++) {
+            if (data[i] != padding) {
+                throw invalid_argument("Relleno PKCS#7 invalido");
+            }
+        }
+        return length - padding;
+    }
+
+    // Transformar blockCount bloques big-endian de input a output en lotes sobre la pila.
+    // transform(bloques, n) trabaja en el lugar; input y output pueden coincidir.
+    template <typename TransformFn>
+    static void transformBytes(const uint8_t* input, uint8_t* output, size_t blockCount, const TransformFn& transform) {
+        uint16_t blocks[BYTE_BATCH_BLOCKS];
+        for (size_t done = 0; done < blockCount; done += BYTE_BATCH_BLOCKS) {
+            size_t count = min(BYTE_BATCH_BLOCKS, blockCount - done);
+            const uint8_t* source = input + done * BLOCK_BYTES;
+            for (size_t i = 0; i < count; i++) {
+                blocks[i] = static_cast<uint16_t>((source[2 * i] << 8) | source[2 * i + 1]);
+            }
+            transform(blocks, count);
+            uint8_t* target = output + done * BLOCK_BYTES;
+            for (size_t i = 0; i < count; i++) {
+                target[2 * i] = static_cast<uint8_t>(blocks[i] >> 8);
+                target[2 * i + 1] = static_cast<uint8_t>(blocks[i] & 0xFF);
+            }
+        }
+    }
+
+    static void storeBlock(uint8_t* output, uint16_t block) {
+        output[0] = static_cast<uint8_t>(block >> 8);
+        output[1] = static_cast<uint8_t>(block & 0xFF);
+    }
+
+    // Leer count bloques desde el bloque firstBlock de length bytes; el último byte impar
+    // se completa con un cero como en stringToBlocks16
+    static void loadBlocks(const uint8_t* data, size_t length, size_t firstBlock, uint16_t* blocks, size_t count) {
+        const uint8_t* source = data + firstBlock * BLOCK_BYTES;
+        size_t available = length - firstBlock * BLOCK_BYTES;
+        size_t whole = min(count, available / BLOCK_BYTES);
+        for (size_t i = 0; i < whole; i++) {
+            blocks[i] = static_cast<uint16_t>((source[2 * i] << 8) | source[2 * i + 1]);
+        }
+        if (whole < count) {
+            blocks[whole] = static_cast<uint16_t>(source[2 * whole] << 8);
+        }
+    }
+
+    // Agregar bloques como texto omitiendo los bytes nulos, como blocksToString
+    static void appendText(string& text, const uint16_t* blocks, size_t count) {
+        size_t start = text.size();
+        text.resize(start + count * BLOCK_BYTES);
+        char* output = &text[start];
+        for (size_t i = 0; i < count; i++) {
+            char highByte = static_cast<char>((blocks[i] >> 8) & 0xFF);
+            char lowByte = static_cast<char>(blocks[i] & 0xFF);
+            *output = highByte;
+            output += highByte != 0;
+            *output = lowByte;
+            output += lowByte != 0;
+        }
+        text.resize(static_cast<size_t>(output - text.data()));
+    }
+
+    // ========== TUBERÍAS BASE64 POR MOSAICOS ==========
+    // Convierten entre Base64 y bloques de 16 bits por mosaicos que caben en L1, sin pasar
+    // por una cadena binaria ni un vector con el mensaje completo. Los modos las usan para
+    // fusionar cifrado y codificación en una sola pasada.
+
+    // Bloques por mosaico: 3 KB de datos, múltiplo de 3 para no partir grupos Base64
+    static constexpr size_t BASE64_TILE_BLOCKS = 1536;
+    static constexpr size_t BASE64_TILE_CHARS = BASE64_TILE_BLOCKS * BLOCK_BYTES / 3 * 4;
+
+    // Codificar prefix seguido de blockCount bloques big-endian. fill(bloques, primero, n)
+    // escribe en el mosaico los bloques [primero, primero + n) ya transformados.
+    template <typename FillFn>
+    static string blockTilesToBase64(const uint8_t* prefix, size_t prefixLength, size_t blockCount, const FillFn& fill) {
+        size_t totalBytes = prefixLength + blockCount * BLOCK_BYTES;
+        string result((totalBytes + 2) / 3 * 4, '\0');
+        char* output = &result[0];
+
+        Base64StreamEncoder encoder;
+        size_t written = encoder.update(prefix, prefixLength, output);
+        uint16_t blocks[BASE64_TILE_BLOCKS];
+        uint8_t bytes[BASE64_TILE_BLOCKS * BLOCK_BYTES];
+        for (size_t start = 0; start < blockCount; start += BASE64_TILE_BLOCKS) {
+            size_t count = min(BASE64_TILE_BLOCKS, blockCount - start);
+            fill(blocks, start, count);
+            for (size_t i = 0; i < count; i++) {
+                storeBlock(bytes + 2 * i, blocks[i]);
+            }
+            written += encoder.update(bytes, count * BLOCK_BYTES, output + written);
+        }
+        encoder.final(output + written);
+        return result;
+    }
+
+    // Decodificar Base64 en prefixLength bytes de prefix seguidos de bloques big-endian; a
+    // sink(bloques, n) llegan los bloques por mosaicos, con el prefijo ya completo. Un byte
+    // final sin pareja se completa con un cero como en readBlock.
+    template <typename SinkFn>
+    static void base64ToBlockTiles(const string& base64Data, uint8_t* prefix, size_t prefixLength, const SinkFn& sink) {
+        Base64StreamDecoder decoder;
+        uint8_t bytes[BASE64_TILE_BLOCKS * BLOCK_BYTES];
+        uint16_t blocks[BASE64_TILE_BLOCKS + 1];
+        size_t prefixRead = 0;
+        bool hasPendingByte = false;
+        uint8_t pendingByte = 0;
+
+        auto consume = [&](const uint8_t* data, size_t length) {
+            while (prefixRead < prefixLength && length > 0) {
+                prefix[prefixRead++] = *data++;
+                length--;
+            }
+            size_t count = 0;
+            if (hasPendingByte && length > 0) {
+                blocks[count++] = static_cast<uint16_t>((pendingByte << 8) | *data++);
+                length--;
+                hasPendingByte = false;
+            }
+            for (; length >= BLOCK_BYTES; length -= BLOCK_BYTES, data += BLOCK_BYTES) {
+                blocks[count++] = static_cast<uint16_t>((data[0] << 8) | data[1]);
+            }
+            if (length == 1) {
+                pendingByte = data[0];
+                hasPendingByte = true;
+            }
+            if (count > 0) {
+                sink(blocks, count);
+            }
+        };
+
+        for (size_t pos = 0; pos < base64Data.length(); pos += BASE64_TILE_CHARS) {
+            size_t chunk = min(BASE64_TILE_CHARS, base64Data.length() - pos);
+            consume(bytes, decoder.update(base64Data.data() + pos, chunk, bytes));
+        }
+        consume(bytes, decoder.final(bytes));
+
+        if (prefixRead < prefixLength) {
+            throw invalid_argument("Datos insuficientes para extraer IV");
+        }
+        if (hasPendingByte) {
+            uint16_t last = static_cast<uint16_t>(pendingByte << 8);
+            sink(&last, 1);
+        }
+    }
+
     // ========== FUNCIONES DE CONVERSIÓN ==========
 
     // Convertir texto a bloques de 16 bits
-    static vector<bitset<16>> stringToBlocks(const string& text) {
-        vector<bitset<16>> blocks;
+    static vector<uint16_t> stringToBlocks16(const string& text) {
+        vector<uint16_t> blocks;
+        blocks.reserve((text.length() + 1) / 2);
         
         for (size_t i = 0; i < text.length(); i += 2) {
-            uint16_t blockValue = 0;
-            
-            blockValue |= (static_cast<uint16_t>(text[i]) << 8);
-            
-            if (i + 1 < text.length()) {
-                blockValue |= static_cast<uint16_t>(text[i + 1]);
-            }
-            
-            blocks.push_back(bitset<16>(blockValue));
+            blocks.push_back(readBlock(text, i));
         }
         
         return blocks;
     }
 
+    static vector<bitset<16>> stringToBlocks(const string& text) {
+        return toBitsets(stringToBlocks16(text));
+    }
+
     // Convertir bloques de 16 bits a texto
-    static string blocksToString(const vector<bitset<16>>& blocks) {
+    static string blocksToString(const vector<uint16_t>& blocks) {
         string result;
-        
-        for (const auto& block : blocks) {
-            uint16_t value = static_cast<uint16_t>(block.to_ulong());
-            
-            char highByte = static_cast<char>((value >> 8) & 0xFF);
-            if (highByte != 0) {
-                result += highByte;
-            }
-            
-            char lowByte = static_cast<char>(value & 0xFF);
-            if (lowByte != 0) {
-                result += lowByte;
-            }
-        }
-        
+        result.reserve(blocks.size() * 2);
+        appendText(result, blocks.data(), blocks.size());
         return result;
     }
 
+    static string blocksToString(const vector<bitset<16>>& blocks) {
+        return blocksToString(toBlocks16(blocks));
+    }
+
     // Convertir bloques a Base64
+    static string blocksToBase64(const vector<uint16_t>& blocks) {
+        return blockTilesToBase64(nullptr, 0, blocks.size(), [&blocks](uint16_t* tile, size_t start, size_t count) {
+            copy(blocks.begin() + start, blocks.begin() + start + count, tile);
+        });
+    }
+
     static string blocksToBase64(const vector<bitset<16>>& blocks) {
-        string binaryData;
-        
-        for (const auto& block : blocks) {
-            uint16_t value = static_cast<uint16_t>(block.to_ulong());
-            binaryData += static_cast<char>((value >> 8) & 0xFF);
-            binaryData += static_cast<char>(value & 0xFF);
-        }
-        
-        return base64_encode(binaryData);
+        return blocksToBase64(toBlocks16(blocks));
     }
 
     // Convertir Base64 a bloques
-    static vector<bitset<16>> base64ToBlocks(const string& base64Data) {
-        vector<bitset<16>> blocks;
-        string decodedData = base64_decode(base64Data);
-        
-        for (size_t i = 0; i < decodedData.length(); i += 2) {
-            uint16_t blockValue = 0;
-            
-            blockValue |= (static_cast<uint16_t>(static_cast<unsigned char>(decodedData[i])) << 8);
-            
-            if (i + 1 < decodedData.length()) {
-                blockValue |= static_cast<uint16_t>(static_cast<unsigned char>(decodedData[i + 1]));
-            }
-            
-            blocks.push_back(bitset<16>(blockValue));
-        }
-        
+    static vector<uint16_t> base64ToBlocks16(const string& base64Data) {
+        vector<uint16_t> blocks;
+        blocks.reserve(base64Data.length() / 4 * 3 / 2 + 1);
+        base64ToBlockTiles(base64Data, nullptr, 0, [&blocks](const uint16_t* tile, size_t count) {
+            blocks.insert(blocks.end(), tile, tile + count);
+        });
         return blocks;
     }
 
+    static vector<bitset<16>> base64ToBlocks(const string& base64Data) {
+        return toBitsets(base64ToBlocks16(base64Data));
+    }
+
     // Convertir bitset a Base64
     static string bitsetToBase64(const bitset<16>& bits) {
         uint16_t value = static_cast<uint16_t>(bits.to_ulong());
@@ -210,98 +410,60 @@ public:
     // ========== FUNCIONES CBC GENERALIZADAS ==========
 
     // Convertir IV y bloques a Base64 (versión generalizada)
+    static string ivAndBlocksToBase64(uint16_t iv, const vector<uint16_t>& blocks) {
+        uint8_t prefix[2];
+        storeBlock(prefix, iv);
+        return blockTilesToBase64(prefix, 2, blocks.size(), [&blocks](uint16_t* tile, size_t start, size_t count) {
+            copy(blocks.begin() + start, blocks.begin() + start + count, tile);
+        });
+    }
+
     static string ivAndBlocksToBase64(const bitset<16>& iv, const vector<bitset<16>>& blocks) {
-        string binaryData;
-        
-        // Agregar IV al inicio
-        uint16_t ivValue = static_cast<uint16_t>(iv.to_ulong());
-        binaryData += static_cast<char>((ivValue >> 8) & 0xFF);
-        binaryData += static_cast<char>(ivValue & 0xFF);
-        
-        // Agregar bloques
-        for (const auto& block : blocks) {
-            uint16_t value = static_cast<uint16_t>(block.to_ulong());
-            binaryData += static_cast<char>((value >> 8) & 0xFF);
-            binaryData += static_cast<char>(value & 0xFF);
-        }
-        
-        return base64_encode(binaryData);
+        return ivAndBlocksToBase64(static_cast<uint16_t>(iv.to_ulong()), toBlocks16(blocks));
     }
 
     // Convertir Base64 a IV y bloques (versión generalizada)
+    static pair<uint16_t, vector<uint16_t>> base64ToIvAndBlocks16(const string& base64Data) {
+        uint8_t prefix[2];
+        vector<uint16_t> blocks;
+        blocks.reserve(base64Data.length() / 4 * 3 / 2);
+        base64ToBlockTiles(base64Data, prefix, 2, [&blocks](const uint16_t* tile, size_t count) {
+            blocks.insert(blocks.end(), tile, tile + count);
+        });
+        return {static_cast<uint16_t>((prefix[0] << 8) | prefix[1]), blocks};
+    }
+
     static pair<bitset<16>, vector<bitset<16>>> base64ToIvAndBlocks(const string& base64Data) {
-        string decodedData = base64_decode(base64Data);
-        
-        if (decodedData.length() < 2) {
-            throw invalid_argument("Datos insuficientes para extraer IV");
-        }
-        
-        // Extraer IV (primeros 2 bytes)
-        uint16_t ivValue = (static_cast<uint16_t>(static_cast<unsigned char>(decodedData[0])) << 8) |
-                           static_cast<uint16_t>(static_cast<unsigned char>(decodedData[1]));
-        bitset<16> iv(ivValue);
-        
-        // Extraer bloques restantes
-        vector<bitset<16>> blocks;
-        for (size_t i = 2; i < decodedData.length(); i += 2) {
-            uint16_t blockValue = 0;
-            
-            blockValue |= (static_cast<uint16_t>(static_cast<unsigned char>(decodedData[i])) << 8);
-            
-            if (i + 1 < decodedData.length()) {
-                blockValue |= static_cast<uint16_t>(static_cast<unsigned char>(decodedData[i + 1]));
-            }
-            
-            blocks.push_back(bitset<16>(blockValue));
-        }
-        
-        return {iv, blocks};
+        pair<uint16_t, vector<uint16_t>> decoded = base64ToIvAndBlocks16(base64Data);
+        return {bitset<16>(decoded.first), toBitsets(decoded.second)};
     }
 
     // Convertir IV y bloques a Base64 (para CTR)
+    static string ctrToBase64(uint8_t iv, const vector<uint16_t>& blocks) {
+        return blockTilesToBase64(&iv, 1, blocks.size(), [&blocks](uint16_t* tile, size_t start, size_t count) {
+            copy(blocks.begin() + start, blocks.begin() + start + count, tile);
+        });
+    }
+
     static string ctrToBase64(const bitset<8>& iv, const vector<bitset<16>>& blocks) {
-        string binaryData;
-        
-        // Agregar IV al inicio
-        binaryData += static_cast<char>(iv.to_ulong());
-        
-        // Agregar bloques cifrados
-        for (const auto& block : blocks) {
-            uint16_t value = static_cast<uint16_t>(block.to_ulong());
-            binaryData += static_cast<char>((value >> 8) & 0xFF);
-            binaryData += static_cast<char>(value & 0xFF);
-        }
-        
-        return base64_encode(binaryData);
+        return ctrToBase64(static_cast<uint8_t>(iv.to_ulong()), toBlocks16(blocks));
     }
 
     // Convertir Base64 a IV y bloques (para CTR)
-    static pair<bitset<8>, vector<bitset<16>>> base64ToCTR(const string& base64Data) {
-        string decodedData = base64_decode(base64Data);
-        
-        if (decodedData.length() < 1) {
-            throw invalid_argument("Datos insuficientes para extraer IV");
-        }
-        
-        // Extraer IV (primer byte)
-        bitset<8> iv(static_cast<unsigned char>(decodedData[0]));
-        
-        // Extraer bloques restantes
-        vector<bitset<16>> blocks;
-        for (size_t i = 1; i < decodedData.length(); i += 2) {
-            uint16_t blockValue = 0;
-            
-            blockValue |= (static_cast<uint16_t>(static_cast<unsigned char>(decodedData[i])) << 8);
-            
-            if (i + 1 < decodedData.length()) {
-                blockValue |= static_cast<uint16_t>(static_cast<unsigned char>(decodedData[i + 1]));
-            }
-            
-            blocks.push_back(bitset<16>(blockValue));
-        }
-        
+    static pair<uint8_t, vector<uint16_t>> base64ToCTR16(const string& base64Data) {
+        uint8_t iv = 0;
+        vector<uint16_t> blocks;
+        blocks.reserve(base64Data.length() / 4 * 3 / 2);
+        base64ToBlockTiles(base64Data, &iv, 1, [&blocks](const uint16_t* tile, size_t count) {
+            blocks.insert(blocks.end(), tile, tile + count);
+        });
         return {iv, blocks};
     }
+
+    static pair<bitset<8>, vector<bitset<16>>> base64ToCTR(const string& base64Data) {
+        pair<uint8_t, vector<uint16_t>> decoded = base64ToCTR16(base64Data);
+        return {bitset<8>(decoded.first), toBitsets(decoded.second)};
+    }
 };
 
 #endif
@@ -0,0 +1,18 @@
+#ifndef IOERROR_H
+#define IOERROR_H
+
+#include <string>
+#include <stdexcept>
+
+using namespace std;
+
+// ========== ERROR DE LECTURA/ESCRITURA ==========
+// Fallos al abrir, leer, escribir o mapear archivos y flujos. Se distingue de los demás
+// runtime_error (por ejemplo, los del generador aleatorio de OpenSSL) para que quien llama
+// pueda separar un problema de E/S de uno interno.
+class IOError : public runtime_error {
+public:
+    explicit IOError(const string& message) : runtime_error(message) {}
+};
+
+#endif
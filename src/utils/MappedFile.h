@@ -0,0 +1,285 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include "IOError.h"
+
+// Mapeo de archivos con mmap en sistemas POSIX; en otros se leen y escriben ventanas con fstream
+#if defined(__unix__) || defined(__APPLE__)
+#define TOYCIPHER_POSIX_MMAP 1
+#endif
+
+#ifdef TOYCIPHER_POSIX_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <fstream>
+#include <filesystem>
+#endif
+
+using namespace std;
+
+// ========== ARCHIVO MAPEADO POR VENTANAS ==========
+// Un archivo se recorre por ventanas mapeadas en memoria, de modo que archivos más grandes
+// que la RAM se procesan sin copiarlos por iostreams: cada ventana se mapea con una pista de
+// acceso secuencial (madvise) y se libera al terminar con ella. El archivo de salida se
+// reserva completo de antemano (posix_fallocate) antes de mapear sus ventanas.
+class MappedFile {
+public:
+    enum class Access {
+        READ,       // archivo existente, solo lectura
+        CREATE      // archivo nuevo o truncado, lectura y escritura
+    };
+
+    // Región [offset, offset + length) del archivo accesible en memoria
+    class Window {
+    private:
+        friend class MappedFile;
+        uint8_t* bytes = nullptr;
+        size_t length = 0;
+#ifdef TOYCIPHER_POSIX_MMAP
+        void* base = nullptr;       // inicio del mapeo, alineado a página
+        size_t mappedLength = 0;
+#else
+        vector<uint8_t> buffer;
+        MappedFile* file = nullptr;
+        uint64_t offset = 0;
+#endif
+
+    public:
+        Window() {}
+        Window(const Window&) = delete;
+        Window& operator=(const Window&) = delete;
+
+        Window(Window&& other) noexcept {
+            *this = std::move(other);
+        }
+
+        Window& operator=(Window&& other) noexcept {
+            if (this != &other) {
+                try {
+                    release();
+                } catch (...) {
+                }
+                bytes = other.bytes;
+                length = other.length;
+#ifdef TOYCIPHER_POSIX_MMAP
+                base = other.base;
+                mappedLength = other.mappedLength;
+                other.base = nullptr;
+                other.mappedLength = 0;
+#else
+                buffer = std::move(other.buffer);
+                bytes = buffer.data();
+                file = other.file;
+                offset = other.offset;
+                other.file = nullptr;
+#endif
+                other.bytes = nullptr;
+                other.length = 0;
+            }
+            return *this;
+        }
+
+        ~Window() {
+            try {
+                release();
+            } catch (...) {
+            }
+        }
+
+        uint8_t* data() {
+            return bytes;
+        }
+
+        const uint8_t* data() const {
+            return bytes;
+        }
+
+        size_t size() const {
+            return length;
+        }
+
+        // Desmapear la ventana (o escribirla de vuelta si no hay mmap)
+        void release() {
+#ifdef TOYCIPHER_POSIX_MMAP
+            if (base != nullptr) {
+                munmap(base, mappedLength);
+                base = nullptr;
+            }
+#else
+            if (file != nullptr && file->writable) {
+                file->stream.seekp(static_cast<streamoff>(offset));
+                file->stream.write(reinterpret_cast<const char*>(buffer.data()), static_cast<streamsize>(buffer.size()));
+                if (!file->stream) {
+                    file = nullptr;
+                    throw IOError("Error: No se pudo escribir el archivo");
+                }
+            }
+            file = nullptr;
+            buffer.clear();
+#endif
+            bytes = nullptr;
+            length = 0;
+        }
+    };
+
+private:
+    string path;
+    bool writable;
+    uint64_t fileSize = 0;
+#ifdef TOYCIPHER_POSIX_MMAP
+    int fd = -1;
+#else
+    fstream stream;
+#endif
+
+    [[noreturn]] void fail(const string& action) const {
+        throw IOError("Error: No se pudo " + action + " el archivo '" + path + "'");
+    }
+
+public:
+    MappedFile(const string& filePath, Access access) : path(filePath), writable(access == Access::CREATE) {
+#ifdef TOYCIPHER_POSIX_MMAP
+        fd = writable ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            fail("abrir");
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            fail("leer el tamano de");
+        }
+        fileSize = static_cast<uint64_t>(info.st_size);
+#else
+        ios::openmode mode = ios::binary | ios::in;
+        if (writable) {
+            mode |= ios::out | ios::trunc;
+        }
+        stream.open(path, mode);
+        if (!stream) {
+            fail("abrir");
+        }
+        stream.seekg(0, ios::end);
+        fileSize = static_cast<uint64_t>(stream.tellg());
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifdef TOYCIPHER_POSIX_MMAP
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    uint64_t size() const {
+        return fileSize;
+    }
+
+    // Indicar si otherPath es este mismo archivo (otro nombre o enlace incluido); abrir la
+    // salida con Access::CREATE sobre la entrada la truncaría mientras se lee
+    bool isSameFile(const string& otherPath) const {
+#ifdef TOYCIPHER_POSIX_MMAP
+        struct stat self;
+        struct stat other;
+        if (fstat(fd, &self) != 0 || stat(otherPath.c_str(), &other) != 0) {
+            return false;
+        }
+        return self.st_dev == other.st_dev && self.st_ino == other.st_ino;
+#else
+        error_code error;
+        return filesystem::equivalent(path, otherPath, error);
+#endif
+    }
+
+    // Fijar el tamaño del archivo; al crecer se reservan los bloques de disco de una vez
+    void resize(uint64_t newSize) {
+        if (!writable) {
+            throw logic_error("El archivo se abrio solo para lectura");
+        }
+#ifdef TOYCIPHER_POSIX_MMAP
+#if defined(__linux__)
+        // Si el sistema de archivos no admite la reserva basta con ftruncate; cualquier otro
+        // error (p. ej. ENOSPC) se informa ya, antes de que escribir en el mapeo dé SIGBUS
+        if (newSize > fileSize) {
+            int result = posix_fallocate(fd, static_cast<off_t>(fileSize), static_cast<off_t>(newSize - fileSize));
+            if (result != 0 && result != EOPNOTSUPP && result != EINVAL) {
+                fail("reservar espacio para");
+            }
+        }
+#endif
+        if (ftruncate(fd, static_cast<off_t>(newSize)) != 0) {
+            fail("redimensionar");
+        }
+#else
+        if (newSize < fileSize) {
+            // fstream no puede acortar un archivo: se reescribe el prefijo
+            vector<char> prefix(static_cast<size_t>(newSize));
+            stream.seekg(0);
+            stream.read(prefix.data(), static_cast<streamsize>(prefix.size()));
+            stream.close();
+            stream.open(path, ios::binary | ios::in | ios::out | ios::trunc);
+            stream.write(prefix.data(), static_cast<streamsize>(prefix.size()));
+        } else if (newSize > fileSize) {
+            stream.seekp(static_cast<streamoff>(newSize - 1));
+            stream.put('\0');
+        }
+        stream.flush();
+        if (!stream) {
+            fail("redimensionar");
+        }
+#endif
+        fileSize = newSize;
+    }
+
+    // Mapear [offset, offset + length); la ventana debe caber en el tamaño actual del archivo
+    Window map(uint64_t offset, size_t length) {
+        if (offset + length > fileSize) {
+            throw out_of_range("Ventana fuera del archivo '" + path + "'");
+        }
+        Window window;
+        if (length == 0) {
+            return window;
+        }
+#ifdef TOYCIPHER_POSIX_MMAP
+        // mmap exige un desplazamiento alineado a página
+        static const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        uint64_t alignedOffset = offset - offset % pageSize;
+        size_t delta = static_cast<size_t>(offset - alignedOffset);
+        int protection = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* base = mmap(nullptr, length + delta, protection, MAP_SHARED, fd, static_cast<off_t>(alignedOffset));
+        if (base == MAP_FAILED) {
+            fail("mapear");
+        }
+        madvise(base, length + delta, MADV_SEQUENTIAL);
+        window.base = base;
+        window.mappedLength = length + delta;
+        window.bytes = static_cast<uint8_t*>(base) + delta;
+#else
+        window.buffer.resize(length);
+        stream.seekg(static_cast<streamoff>(offset));
+        stream.read(reinterpret_cast<char*>(window.buffer.data()), static_cast<streamsize>(length));
+        if (!stream) {
+            fail("leer");
+        }
+        window.bytes = window.buffer.data();
+        window.file = this;
+        window.offset = offset;
+#endif
+        window.length = length;
+        return window;
+    }
+};
+
+#endif
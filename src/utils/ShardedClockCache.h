@@ -0,0 +1,211 @@
+#ifndef SHARDEDCLOCKCACHE_H
+#define SHARDEDCLOCKCACHE_H
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// ========== CACHÉ CONCURRENTE CON DESALOJO CLOCK ==========
+// Las entradas se reparten en shards independientes, cada uno con su propio mutex,
+// de modo que hilos que consultan claves distintas casi nunca compiten por el mismo candado.
+// Cada entrada declara su costo en bytes; cuando un shard supera su parte del presupuesto
+// de memoria, la manecilla del reloj recorre las entradas y desaloja la primera que no
+// haya sido consultada desde la vuelta anterior (aproximación de LRU sin listas enlazadas).
+template <typename K, typename V, typename Hash = hash<K>>
+class ShardedClockCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t memoryUsed = 0;
+        size_t memoryBudget = 0;
+    };
+
+    static constexpr size_t DEFAULT_SHARDS = 16;
+
+private:
+    struct Slot {
+        K key;
+        V value;
+        size_t charge = 0;
+        bool referenced = false;
+        bool occupied = false;
+    };
+
+    struct Shard {
+        mutable mutex lock;
+        unordered_map<K, size_t, Hash> index;
+        vector<Slot> slots;
+        vector<size_t> freeSlots;
+        size_t hand = 0;
+        size_t memoryUsed = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+    };
+
+    vector<unique_ptr<Shard>> shards;
+    size_t shardBudget;
+    Hash hasher;
+
+    Shard& shardFor(const K& key) const {
+        // Mezclar los bits altos para que hashes secuenciales no caigan en el mismo shard
+        uint64_t h = static_cast<uint64_t>(hasher(key)) * 0x9E3779B97F4A7C15ULL;
+        return *shards[(h >> 32) % shards.size()];
+    }
+
+    void releaseSlot(Shard& shard, size_t position) {
+        Slot& slot = shard.slots[position];
+        shard.index.erase(slot.key);
+        shard.memoryUsed -= slot.charge;
+        slot = Slot();
+        shard.freeSlots.push_back(position);
+    }
+
+    // Desalojar con la manecilla del reloj hasta que quepan "incoming" bytes más
+    void evictFor(Shard& shard, size_t incoming) {
+        size_t steps = 0;
+        size_t limit = 2 * shard.slots.size();
+        while (shard.memoryUsed + incoming > shardBudget && !shard.index.empty() && steps <= limit) {
+            Slot& slot = shard.slots[shard.hand];
+            if (slot.occupied) {
+                if (slot.referenced) {
+                    slot.referenced = false;
+                } else {
+                    releaseSlot(shard, shard.hand);
+                    shard.evictions++;
+                }
+            }
+            shard.hand = (shard.hand + 1) % shard.slots.size();
+            steps++;
+        }
+    }
+
+public:
+    explicit ShardedClockCache(size_t memoryBudget, size_t shardCount = DEFAULT_SHARDS) {
+        if (shardCount == 0) {
+            throw invalid_argument("El cache necesita al menos un shard");
+        }
+        shards.reserve(shardCount);
+        for (size_t i = 0; i < shardCount; i++) {
+            shards.push_back(make_unique<Shard>());
+        }
+        shardBudget = memoryBudget / shardCount;
+    }
+
+    ShardedClockCache(const ShardedClockCache&) = delete;
+    ShardedClockCache& operator=(const ShardedClockCache&) = delete;
+
+    // Buscar una entrada; si existe se copia en value y se marca como referenciada
+    bool lookup(const K& key, V& value) {
+        Shard& shard = shardFor(key);
+        lock_guard<mutex> guard(shard.lock);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            shard.misses++;
+            return false;
+        }
+        Slot& slot = shard.slots[it->second];
+        slot.referenced = true;
+        value = slot.value;
+        shard.hits++;
+        return true;
+    }
+
+    // Insertar o reemplazar una entrada con su costo en bytes.
+    // Devuelve false si la entrada por sí sola no cabe en el presupuesto del shard.
+    bool insert(const K& key, V value, size_t charge) {
+        Shard& shard = shardFor(key);
+        lock_guard<mutex> guard(shard.lock);
+        if (charge > shardBudget) {
+            return false;
+        }
+
+        // Un reemplazo conserva la referencia de la entrada anterior
+        bool replaced = false;
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            replaced = shard.slots[it->second].referenced;
+            releaseSlot(shard, it->second);
+        }
+        evictFor(shard, charge);
+
+        size_t position;
+        if (!shard.freeSlots.empty()) {
+            position = shard.freeSlots.back();
+            shard.freeSlots.pop_back();
+        } else {
+            position = shard.slots.size();
+            shard.slots.emplace_back();
+        }
+
+        Slot& slot = shard.slots[position];
+        slot.key = key;
+        slot.value = move(value);
+        slot.charge = charge;
+        // Las entradas nuevas empiezan sin referencia: una clave vista una sola vez sale primero
+        slot.referenced = replaced;
+        slot.occupied = true;
+        shard.index.emplace(key, position);
+        shard.memoryUsed += charge;
+        shard.insertions++;
+        return true;
+    }
+
+    // Indicar si una entrada de este costo cabe en el presupuesto de un shard
+    bool fits(size_t charge) const {
+        return charge <= shardBudget;
+    }
+
+    bool erase(const K& key) {
+        Shard& shard = shardFor(key);
+        lock_guard<mutex> guard(shard.lock);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            return false;
+        }
+        releaseSlot(shard, it->second);
+        return true;
+    }
+
+    void clear() {
+        for (auto& shard : shards) {
+            lock_guard<mutex> guard(shard->lock);
+            shard->index.clear();
+            shard->slots.clear();
+            shard->freeSlots.clear();
+            shard->hand = 0;
+            shard->memoryUsed = 0;
+        }
+    }
+
+    // Sumar los contadores de todos los shards
+    Stats getStats() const {
+        Stats stats;
+        stats.memoryBudget = shardBudget * shards.size();
+        for (const auto& shard : shards) {
+            lock_guard<mutex> guard(shard->lock);
+            stats.hits += shard->hits;
+            stats.misses += shard->misses;
+            stats.insertions += shard->insertions;
+            stats.evictions += shard->evictions;
+            stats.entries += shard->index.size();
+            stats.memoryUsed += shard->memoryUsed;
+        }
+        return stats;
+    }
+};
+
+#endif
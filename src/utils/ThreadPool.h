@@ -0,0 +1,139 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <algorithm>
+#include <cstddef>
+
+using namespace std;
+
+// ========== POOL DE HILOS DE TAMAÑO FIJO ==========
+// Los hilos se crean una sola vez y atienden una cola de tareas. parallelFor reparte
+// un rango [0, count) en tramos contiguos: el hilo que llama procesa el primero y
+// espera al resto, propagando la primera excepción que ocurra.
+class ThreadPool {
+private:
+    vector<thread> workers;
+    queue<function<void()>> tasks;
+    mutex queueLock;
+    condition_variable queueReady;
+    bool stopping = false;
+
+    // Marca los hilos del pool para que un parallelFor anidado se ejecute en serie
+    static bool& insideWorker() {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    void workerLoop() {
+        insideWorker() = true;
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock<mutex> guard(queueLock);
+                queueReady.wait(guard, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) {
+                    return;
+                }
+                task = move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+public:
+    // Por defecto un hilo por núcleo; el hilo que llama cuenta como uno de ellos
+    explicit ThreadPool(size_t numThreads = max(1u, thread::hardware_concurrency())) {
+        for (size_t i = 1; i < numThreads; i++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> guard(queueLock);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Número de hilos que participan en parallelFor (incluye al que llama)
+    size_t size() const {
+        return workers.size() + 1;
+    }
+
+    // Encolar una tarea y obtener un future para esperar su resultado
+    template <typename Task>
+    future<void> submit(Task task) {
+        auto packaged = make_shared<packaged_task<void()>>(move(task));
+        future<void> result = packaged->get_future();
+        {
+            lock_guard<mutex> guard(queueLock);
+            tasks.emplace([packaged] { (*packaged)(); });
+        }
+        queueReady.notify_one();
+        return result;
+    }
+
+    // Ejecutar rangeFn(begin, end) sobre tramos contiguos de al menos minChunk elementos
+    template <typename RangeFn>
+    void parallelFor(size_t count, size_t minChunk, const RangeFn& rangeFn) {
+        if (count == 0) {
+            return;
+        }
+        size_t numChunks = min(size(), max<size_t>(1, count / max<size_t>(1, minChunk)));
+        if (numChunks <= 1 || insideWorker()) {
+            rangeFn(size_t(0), count);
+            return;
+        }
+
+        size_t chunkSize = (count + numChunks - 1) / numChunks;
+        vector<future<void>> pending;
+        pending.reserve(numChunks - 1);
+        for (size_t begin = chunkSize; begin < count; begin += chunkSize) {
+            size_t end = min(begin + chunkSize, count);
+            pending.push_back(submit([&rangeFn, begin, end] { rangeFn(begin, end); }));
+        }
+
+        // El hilo actual procesa el primer tramo; luego se esperan todos antes de propagar errores
+        exception_ptr firstError;
+        try {
+            rangeFn(size_t(0), min(chunkSize, count));
+        } catch (...) {
+            firstError = current_exception();
+        }
+        for (auto& result : pending) {
+            try {
+                result.get();
+            } catch (...) {
+                if (!firstError) {
+                    firstError = current_exception();
+                }
+            }
+        }
+        if (firstError) {
+            rethrow_exception(firstError);
+        }
+    }
+
+    // Pool compartido por todo el proceso
+    static ThreadPool& shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+};
+
+#endif
@@ -23,7 +23,8 @@ public:
         cout << "1. Modo ECB (Electronic Codebook)" << endl;
         cout << "2. Modo CBC (Cipher Block Chaining)" << endl;
         cout << "3. Modo CTR (Counter)" << endl;
-        cout << "4. Salir" << endl;
+        cout << "4. Archivos (ECB, CBC o CTR)" << endl;
+        cout << "5. Salir" << endl;
         cout << "----------------------------------------" << endl;
         cout << "Seleccione el modo de operacion: ";
     }
@@ -40,6 +41,18 @@ public:
         cout << "Seleccione una opcion: ";
     }
 
+    // Mostrar menu de archivos
+    static void showFileMenu() {
+        cout << "\n================================" << endl;
+        cout << "        MODO ARCHIVOS" << endl;
+        cout << "================================" << endl;
+        cout << "1. Cifrar archivo" << endl;
+        cout << "2. Descifrar archivo" << endl;
+        cout << "3. Volver al menu principal" << endl;
+        cout << "--------------------------------" << endl;
+        cout << "Seleccione una opcion: ";
+    }
+
     // Mostrar mensaje de error
     static void showError(const string& operation, const string& errorMsg) {
         cout << "\nError durante " << operation << ": " << errorMsg << endl;
@@ -49,6 +62,25 @@ public:
     static void showSimpleError(const string& errorMsg) {
         cout << "\nError: " << errorMsg << endl;
     }
+
+    // Mostrar la ayuda del modo no interactivo (en stderr si se muestra por un error de uso)
+    static void showUsage(ostream& output) {
+        output << "Uso: cifrador <comando> [opciones]  (sin argumentos abre el menu interactivo)" << endl;
+        output << endl;
+        output << "Comandos:" << endl;
+        output << "  encrypt --mode ecb|cbc|ctr [--key CLAVE] [--batch]   cifra stdin en stdout" << endl;
+        output << "  decrypt --key CLAVE [--batch]                        descifra stdin en stdout" << endl;
+        output << "  keygen                                               escribe una clave nueva en stdout" << endl;
+        output << "  help                                                 muestra esta ayuda" << endl;
+        output << endl;
+        output << "Opciones:" << endl;
+        output << "  --key CLAVE     clave maestra en Base64 (encrypt sin --key genera una y la escribe en stderr)" << endl;
+        output << "  --engine MOTOR  reference, codebook, ttable, bitslice o simd" << endl;
+        output << "  --batch         registros con prefijo de longitud (4 bytes big-endian) en lugar de un solo mensaje" << endl;
+        output << endl;
+        output << "Codigos de salida: 0 correcto, 1 error interno, 2 uso incorrecto," << endl;
+        output << "                   3 error de lectura/escritura, 4 datos invalidos" << endl;
+    }
 };
 
 #endif
\ No newline at end of file